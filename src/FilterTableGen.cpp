@@ -0,0 +1,97 @@
+/*
+ * This file is part of pyresidfp, a SID emulation package for Python.
+ *
+ * Copyright (c) 2018-2023.  Sebastian Klemke <pypi@nerdheim.de>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+/*
+ * Build-time generator of the filter model lookup tables.
+ *
+ * Builds the tables of both chip models with the regular code and writes
+ * them as a C++ source defining FilterTableCache::embedded, so that the
+ * extension module can use them without building them at runtime.
+ */
+
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+
+#include "FilterModelConfig6581.h"
+#include "FilterModelConfig8580.h"
+#include "FilterTableCache.h"
+
+namespace sid = reSIDfp;
+
+namespace {
+
+    bool writeTables(std::FILE *f, const char *symbol, const sid::FilterTableCache &tables) {
+        std::fprintf(f, "alignas(8) const std::uint64_t %s[] =\n{\n", symbol);
+
+        const unsigned char *data = tables.getData();
+        for (std::size_t i = 0; i < tables.getSize(); i += 8) {
+            // Same byte order as the target, the generator runs on the build host
+            std::uint64_t word;
+            std::memcpy(&word, data + i, sizeof(word));
+            std::fprintf(f, "0x%llxu,%s", static_cast<unsigned long long>(word), (i % 64 == 56) ? "\n" : "");
+        }
+
+        return std::fprintf(f, "\n};\n\n") > 0;
+    }
+
+    void writeEntry(std::FILE *f, const char *name, const char *symbol, const sid::FilterTableCache &tables) {
+        std::fprintf(f, "    { \"%s\", 0x%016llxull, %zu, reinterpret_cast<const unsigned char*>(%s) },\n",
+                     name, static_cast<unsigned long long>(tables.getKey()), tables.getSize(), symbol);
+    }
+
+}
+
+int main(int argc, char **argv) {
+    if (argc != 2) {
+        std::fprintf(stderr, "usage: %s <output.cpp>\n", argv[0]);
+        return 1;
+    }
+
+    const sid::FilterTableCache &tables6581 = sid::FilterModelConfig6581::getInstance()->getTables();
+    const sid::FilterTableCache &tables8580 = sid::FilterModelConfig8580::getInstance()->getTables();
+
+    std::FILE *f = std::fopen(argv[1], "w");
+    if (f == nullptr) {
+        std::perror(argv[1]);
+        return 1;
+    }
+
+    std::fprintf(f, "// Generated by FilterTableGen, do not edit.\n\n");
+    std::fprintf(f, "#include \"FilterTableCache.h\"\n\n");
+    std::fprintf(f, "namespace reSIDfp\n{\n\nnamespace\n{\n\n");
+
+    bool ok = writeTables(f, "tables6581", tables6581)
+              && writeTables(f, "tables8580", tables8580);
+
+    std::fprintf(f, "}\n\nconst FilterTableCache::Embedded FilterTableCache::embedded[] =\n{\n");
+    writeEntry(f, "6581", "tables6581", tables6581);
+    writeEntry(f, "8580", "tables8580", tables8580);
+    std::fprintf(f, "    { nullptr, 0, 0, nullptr }\n};\n\n} // namespace reSIDfp\n");
+
+    ok = (std::fclose(f) == 0) && ok;
+    if (!ok) {
+        std::fprintf(stderr, "%s: write error\n", argv[1]);
+        std::remove(argv[1]);
+        return 1;
+    }
+
+    return 0;
+}
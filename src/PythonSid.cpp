@@ -26,11 +26,14 @@ namespace pyreSIDfp {
 
     PythonSid::PythonSid(const sid::ChipModel model, const sid::SamplingMethod method,
                                        const double clockFrequency, const double samplingFrequency) :
-            delegate(new sid::SID()),
+            delegate(new sid::SID(model)),
             chipModel(model),
             samplingMethod(method),
             clockFrequency(clockFrequency),
             samplingFrequency(samplingFrequency),
+            passbandFrequency(0.),
+            ratioAdjustment(0.),
+            densePhaseTables(false),
             isMuted() {
         if (clockFrequency < samplingFrequency) {
             throw sid::SIDError("Clock frequency below sampling frequency");
@@ -41,7 +44,8 @@ namespace pyreSIDfp {
     void PythonSid::reset() {
         delegate->reset();
         delegate->setChipModel(chipModel);
-        delegate->setSamplingParameters(clockFrequency, samplingMethod, samplingFrequency);
+        delegate->setSamplingParameters(clockFrequency, samplingMethod, samplingFrequency, passbandFrequency, densePhaseTables);
+        delegate->setRatioAdjustment(ratioAdjustment);
     }
 
     sid::ChipModel PythonSid::getChipModel() const {
@@ -53,6 +57,19 @@ namespace pyreSIDfp {
         this->reset();
     }
 
+    void PythonSid::setChipProfile(const sid::ChipProfile profile) {
+        this->delegate->setChipProfile(profile);
+        this->chipModel = this->delegate->getChipModel();
+    }
+
+    sid::CombinedWaveforms PythonSid::getCombinedWaveforms() const {
+        return this->delegate->getCombinedWaveforms();
+    }
+
+    void PythonSid::setCombinedWaveforms(const sid::CombinedWaveforms cws) {
+        this->delegate->setCombinedWaveforms(cws);
+    }
+
     sid::SamplingMethod PythonSid::getSamplingMethod() const {
         return samplingMethod;
     }
@@ -62,6 +79,22 @@ namespace pyreSIDfp {
         this->reset();
     }
 
+    sid::Quality PythonSid::getQuality() const {
+        return this->delegate->getQuality();
+    }
+
+    void PythonSid::setQuality(const sid::Quality quality) {
+        this->delegate->setQuality(quality);
+    }
+
+    bool PythonSid::getCompactTables() const {
+        return this->delegate->getCompactTables();
+    }
+
+    void PythonSid::setCompactTables(const bool enable) {
+        this->delegate->setCompactTables(enable);
+    }
+
     double PythonSid::getClockFrequency() const {
         return this->clockFrequency;
     }
@@ -82,10 +115,47 @@ namespace pyreSIDfp {
         if (frequency > this->clockFrequency) {
             throw sid::SIDError("Sampling frequency above clock frequency");
         }
+        if (this->passbandFrequency > 0.45 * frequency) {
+            throw sid::SIDError("Sampling frequency too low for the passband frequency");
+        }
         this->samplingFrequency = frequency;
         this->reset();
     }
 
+    double PythonSid::getPassbandFrequency() const {
+        return this->passbandFrequency;
+    }
+
+    void PythonSid::setPassbandFrequency(const double frequency) {
+        if (frequency > 0.45 * this->samplingFrequency) {
+            throw sid::SIDError("Passband frequency too high for the sampling frequency");
+        }
+        this->passbandFrequency = frequency;
+        this->reset();
+    }
+
+    bool PythonSid::getDensePhaseTables() const {
+        return this->densePhaseTables;
+    }
+
+    void PythonSid::setDensePhaseTables(const bool enable) {
+        this->densePhaseTables = enable;
+        this->reset();
+    }
+
+    double PythonSid::getDelay() const {
+        return this->delegate->getDelay();
+    }
+
+    double PythonSid::getRatioAdjustment() const {
+        return this->ratioAdjustment;
+    }
+
+    void PythonSid::setRatioAdjustment(const double ppm) {
+        this->delegate->setRatioAdjustment(ppm);
+        this->ratioAdjustment = ppm;
+    }
+
     void PythonSid::input(const int value) {
         this->delegate->input(value);
     }
@@ -131,6 +201,10 @@ namespace pyreSIDfp {
         this->delegate->setFilter6581Curve(filterCurve);
     }
 
+    void PythonSid::setFilter6581Range(const double adjustment) {
+        this->delegate->setFilter6581Range(adjustment);
+    }
+
     void PythonSid::setFilter8580Curve(const double filterCurve) {
         this->delegate->setFilter8580Curve(filterCurve);
     }
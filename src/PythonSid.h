@@ -36,6 +36,9 @@ namespace pyreSIDfp {
         reSIDfp::SamplingMethod samplingMethod;
         double clockFrequency;
         double samplingFrequency;
+        double passbandFrequency;
+        double ratioAdjustment;
+        bool densePhaseTables;
         std::bitset<4> isMuted;
 
     public:
@@ -48,10 +51,24 @@ namespace pyreSIDfp {
 
         void setChipModel(reSIDfp::ChipModel model);
 
+        void setChipProfile(reSIDfp::ChipProfile profile);
+
+        reSIDfp::CombinedWaveforms getCombinedWaveforms() const;
+
+        void setCombinedWaveforms(reSIDfp::CombinedWaveforms cws);
+
         reSIDfp::SamplingMethod getSamplingMethod() const;
 
         void setSamplingMethod(reSIDfp::SamplingMethod method);
 
+        reSIDfp::Quality getQuality() const;
+
+        void setQuality(reSIDfp::Quality quality);
+
+        bool getCompactTables() const;
+
+        void setCompactTables(bool enable);
+
         double getClockFrequency() const;
 
         void setClockFrequency(double frequency);
@@ -60,6 +77,20 @@ namespace pyreSIDfp {
 
         void setSamplingFrequency(double frequency);
 
+        double getPassbandFrequency() const;
+
+        void setPassbandFrequency(double frequency);
+
+        bool getDensePhaseTables() const;
+
+        void setDensePhaseTables(bool enable);
+
+        double getDelay() const;
+
+        double getRatioAdjustment() const;
+
+        void setRatioAdjustment(double ppm);
+
         void input(int value);
 
         const unsigned char read(int offset);
@@ -72,6 +103,8 @@ namespace pyreSIDfp {
 
         void setFilter6581Curve(double filterCurve);
 
+        void setFilter6581Range(double adjustment);
+
         void setFilter8580Curve(double filterCurve);
 
         void enableFilter(bool enable);
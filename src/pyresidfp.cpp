@@ -56,6 +56,18 @@ PYBIND11_MODULE(_pyresidfp, m) {
 #endif
 
 
+    m.def("set_cache_directory", &sid::SID::setCacheDirectory, py::arg("path"), R"pbdoc(
+               Set the directory where the filter lookup tables are cached.
+
+               Building the tables takes a noticeable time at the first use of
+               each chip model. Once cached, later processes map the tables
+               read-only and share them. Only chip models first used afterwards
+               are affected.
+
+               Args:
+                   path (str): Cache directory, empty to disable caching
+            )pbdoc");
+
     py::enum_<sid::ChipModel>(m, "ChipModel", R"pbdoc(
                Chip models to emulate.
             )pbdoc")
@@ -68,6 +80,56 @@ PYBIND11_MODULE(_pyresidfp, m) {
                The revised MOS 8580 chip included in C64C
             )pbdoc");
 
+    py::enum_<sid::CombinedWaveforms>(m, "CombinedWaveforms", R"pbdoc(
+               Strength of the combined waveforms.
+            )pbdoc")
+
+            .value("AVERAGE", sid::CombinedWaveforms::AVERAGE, R"pbdoc(
+               Average strength, as sampled from a 6581 R3 and an 8580 R5
+            )pbdoc")
+
+            .value("WEAK", sid::CombinedWaveforms::WEAK, R"pbdoc(
+               Weak strength, as sampled from a 6581 R2 and an 8580 R5
+            )pbdoc")
+
+            .value("STRONG", sid::CombinedWaveforms::STRONG, R"pbdoc(
+               Strong strength, as sampled from a 6581 R2 and an 8580 R5
+            )pbdoc");
+
+    py::enum_<sid::ChipProfile>(m, "ChipProfile", R"pbdoc(
+               Chip revisions to emulate, bundling chip model, combined waveforms
+               strength and filter settings. The filter settings are a starting point,
+               filters vary widely even between chips of the same revision.
+            )pbdoc")
+
+            .value("MOS6581R2", sid::ChipProfile::MOS6581R2, R"pbdoc(
+               6581 R2, weak combined waveforms, darker filter
+            )pbdoc")
+
+            .value("MOS6581R2_STRONG", sid::ChipProfile::MOS6581R2_STRONG, R"pbdoc(
+               6581 R2, strong combined waveforms, darker filter
+            )pbdoc")
+
+            .value("MOS6581R3", sid::ChipProfile::MOS6581R3, R"pbdoc(
+               6581 R3, average combined waveforms, default filter
+            )pbdoc")
+
+            .value("MOS6581R4AR", sid::ChipProfile::MOS6581R4AR, R"pbdoc(
+               6581 R4AR, average combined waveforms, brighter filter
+            )pbdoc")
+
+            .value("MOS8580R5", sid::ChipProfile::MOS8580R5, R"pbdoc(
+               8580 R5, average combined waveforms
+            )pbdoc")
+
+            .value("MOS8580R5_WEAK", sid::ChipProfile::MOS8580R5_WEAK, R"pbdoc(
+               8580 R5, weak combined waveforms
+            )pbdoc")
+
+            .value("MOS8580R5_STRONG", sid::ChipProfile::MOS8580R5_STRONG, R"pbdoc(
+               8580 R5, strong combined waveforms
+            )pbdoc");
+
     py::enum_<sid::SamplingMethod>(m, "SamplingMethod", R"pbdoc(
                Method to sample emulated anologue output.
             )pbdoc")
@@ -78,6 +140,26 @@ PYBIND11_MODULE(_pyresidfp, m) {
 
             .value("RESAMPLE", sid::SamplingMethod::RESAMPLE, R"pbdoc(
                Two-pass resampling
+            )pbdoc")
+
+            .value("RESAMPLE_MINIMUM_PHASE", sid::SamplingMethod::RESAMPLE_MINIMUM_PHASE, R"pbdoc(
+               Two-pass resampling with minimum phase filters, for a lower delay
+            )pbdoc");
+
+    py::enum_<sid::Quality>(m, "Quality", R"pbdoc(
+               Emulation quality levels.
+            )pbdoc")
+
+            .value("REFERENCE", sid::Quality::REFERENCE, R"pbdoc(
+               Full nonlinear filter model
+            )pbdoc")
+
+            .value("FAST", sid::Quality::FAST, R"pbdoc(
+               Linearized filter model, not clocked once it holds still while the voices are idle
+            )pbdoc")
+
+            .value("DRAFT", sid::Quality::DRAFT, R"pbdoc(
+               Linearized filter model clocked at half rate
             )pbdoc");
 
     py::class_<::pysid::PythonSid>(m, "SID", R"pbdoc(
@@ -93,11 +175,9 @@ PYBIND11_MODULE(_pyresidfp, m) {
                The default end of passband frequency is pass_freq = 0.9*sample_freq/2
                for sample frequencies up to ~ 44.1kHz, and 20kHz for higher sample frequencies.
 
-               For resampling, the ratio between the clock frequency and the sample frequency
-               is limited as follows: 125*clock_freq/sample_freq < 16384
-               E.g. provided a clock frequency of ~ 1MHz, the sample frequency can not be set
-               lower than ~ 8kHz. A lower sample frequency would make the resampling code
-               overfill its 16k sample ring buffer.
+               For resampling, low sample frequencies are reached by halving the rate
+               with short half-band filters before the SINC, whenever that is cheaper,
+               so sample frequencies of a few hundred Hz are supported as well.
 
                Args:
                    chip_model (_pyresidfp.ChipModel):  Chip model to emulate
@@ -119,10 +199,22 @@ PYBIND11_MODULE(_pyresidfp, m) {
                _pyresidfp.ChipModel: Chip model to emulate.
             )pbdoc")
 
+            .def_property("combined_waveforms", &::pysid::PythonSid::getCombinedWaveforms, &::pysid::PythonSid::setCombinedWaveforms, R"pbdoc(
+               _pyresidfp.CombinedWaveforms: Strength of the combined waveforms
+            )pbdoc")
+
             .def_property("sampling_method", &::pysid::PythonSid::getSamplingMethod, &::pysid::PythonSid::setSamplingMethod, R"pbdoc(
                _pyresidfp.SamplingMethod: Sampling method to use
             )pbdoc")
 
+            .def_property("quality", &::pysid::PythonSid::getQuality, &::pysid::PythonSid::setQuality, R"pbdoc(
+               _pyresidfp.Quality: Emulation quality, trading filter accuracy for speed
+            )pbdoc")
+
+            .def_property("compact_tables", &::pysid::PythonSid::getCompactTables, &::pysid::PythonSid::setCompactTables, R"pbdoc(
+               bool: Use compact, interpolated filter tables, faster on CPUs with small caches
+            )pbdoc")
+
             .def_property("clock_frequency", &::pysid::PythonSid::getClockFrequency, &::pysid::PythonSid::setClockFrequency, R"pbdoc(
                float: Clock frequency of chip to emulate
             )pbdoc")
@@ -131,6 +223,24 @@ PYBIND11_MODULE(_pyresidfp, m) {
                float: Frequency at which to sample output
             )pbdoc")
 
+            .def_property("passband_frequency", &::pysid::PythonSid::getPassbandFrequency, &::pysid::PythonSid::setPassbandFrequency, R"pbdoc(
+               float: End of passband of the resampling filter, 0 for the default. A lower one is cheaper to compute
+            )pbdoc")
+
+            .def_property("dense_phase_tables", &::pysid::PythonSid::getDensePhaseTables, &::pysid::PythonSid::setDensePhaseTables, R"pbdoc(
+               bool: Resample with dense phase tables, one convolution per sample instead of two,
+               faster as long as the few hundred KiB of tables stay in the cache
+            )pbdoc")
+
+            .def_property("ratio_adjustment", &::pysid::PythonSid::getRatioAdjustment, &::pysid::PythonSid::setRatioAdjustment, R"pbdoc(
+               float: Output sampling rate adjustment in parts per million, up to 1%, to follow the clock of a sound card.
+               Keeps the resampling filters and history, unlike changing the sampling frequency
+            )pbdoc")
+
+            .def_property_readonly("delay", &::pysid::PythonSid::getDelay, R"pbdoc(
+               float: Delay of the output of the sampling method in seconds, at low frequencies
+            )pbdoc")
+
             .def("reset", &::pysid::PythonSid::reset, R"pbdoc(
                Resets chip model, voice registers, filters and sampling method.
 
@@ -206,6 +316,17 @@ PYBIND11_MODULE(_pyresidfp, m) {
                     :obj:`list` of :obj:`int` samples in range -32768 to 32767
             )pbdoc")
 
+            .def("set_chip_profile", &::pysid::PythonSid::setChipProfile, py::arg("profile"), R"pbdoc(
+               Set chip model, combined waveforms strength and filter settings at once.
+               Unlike setting the chip model, this doesn't reset the chip.
+
+               Args:
+                   profile (_pyresidfp.ChipProfile): Chip profile to emulate
+
+               Raises:
+                   RuntimeError
+            )pbdoc")
+
             .def("set_filter_6581_curve", &::pysid::PythonSid::setFilter6581Curve, py::arg("curve_position"), R"pbdoc(
                Set filter curve parameter for 6581 model.
 
@@ -213,6 +334,14 @@ PYBIND11_MODULE(_pyresidfp, m) {
                    curve_position (float): 0 .. 1, where 0 sets center frequency high ("light") and 1 sets it low ("dark"), default is 0.5
             )pbdoc")
 
+            .def("set_filter_6581_range", &::pysid::PythonSid::setFilter6581Range, py::arg("adjustment"), R"pbdoc(
+               Set filter range parameter for 6581 model.
+               Only affects this instance.
+
+               Args:
+                   adjustment (float): 0 .. 1, where 0 sets center frequency low ("dark") and 1 sets it high ("bright"), default is 0.5
+            )pbdoc")
+
             .def("set_filter_8580_curve", &::pysid::PythonSid::setFilter8580Curve, py::arg("curve_position"), R"pbdoc(
                Set filter curve parameter for 8580 model.
 
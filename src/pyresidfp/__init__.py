@@ -16,6 +16,9 @@
 #  along with this program; if not, write to the Free Software
 #  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
 
+import os
+
+from ._pyresidfp import set_cache_directory
 from .musical_scale import Tone
 from .registers import (
     AttackDecayBits,
@@ -29,6 +32,9 @@ from .registers import (
 from .sound_interface_device import SoundInterfaceDevice, Voice, _VoiceRegister
 from ._version import version, version_tuple, __version__, __version_tuple__
 
+if "PYRESIDFP_CACHE_DIR" in os.environ:
+    set_cache_directory(os.environ["PYRESIDFP_CACHE_DIR"])
+
 __all__ = [
     "Tone",
     "AttackDecayBits",
@@ -40,4 +46,5 @@ __all__ = [
     "WritableRegister",
     "SoundInterfaceDevice",
     "Voice",
+    "set_cache_directory",
 ]
@@ -15,7 +15,7 @@ reSIDfp SID (MOS6581 / MOS8580) extension
 from __future__ import annotations
 import typing
 
-__all__: list[str] = ["ChipModel", "SID", "SamplingMethod"]
+__all__: list[str] = ["ChipModel", "ChipProfile", "CombinedWaveforms", "Quality", "SID", "SamplingMethod", "set_cache_directory"]
 
 class ChipModel:
     """
@@ -54,6 +54,154 @@ class ChipModel:
     @property
     def value(self) -> int: ...
 
+class ChipProfile:
+    """
+
+                   Chip revisions to emulate, bundling chip model, combined waveforms
+                   strength and filter settings. The filter settings are a starting point,
+                   filters vary widely even between chips of the same revision.
+
+
+    Members:
+
+      MOS6581R2 :
+                   6581 R2, weak combined waveforms, darker filter
+
+
+      MOS6581R2_STRONG :
+                   6581 R2, strong combined waveforms, darker filter
+
+
+      MOS6581R3 :
+                   6581 R3, average combined waveforms, default filter
+
+
+      MOS6581R4AR :
+                   6581 R4AR, average combined waveforms, brighter filter
+
+
+      MOS8580R5 :
+                   8580 R5, average combined waveforms
+
+
+      MOS8580R5_WEAK :
+                   8580 R5, weak combined waveforms
+
+
+      MOS8580R5_STRONG :
+                   8580 R5, strong combined waveforms
+
+    """
+
+    MOS6581R2: typing.ClassVar[ChipProfile]  # value = <ChipProfile.MOS6581R2: 1>
+    MOS6581R2_STRONG: typing.ClassVar[ChipProfile]  # value = <ChipProfile.MOS6581R2_STRONG: 2>
+    MOS6581R3: typing.ClassVar[ChipProfile]  # value = <ChipProfile.MOS6581R3: 3>
+    MOS6581R4AR: typing.ClassVar[ChipProfile]  # value = <ChipProfile.MOS6581R4AR: 4>
+    MOS8580R5: typing.ClassVar[ChipProfile]  # value = <ChipProfile.MOS8580R5: 5>
+    MOS8580R5_STRONG: typing.ClassVar[ChipProfile]  # value = <ChipProfile.MOS8580R5_STRONG: 7>
+    MOS8580R5_WEAK: typing.ClassVar[ChipProfile]  # value = <ChipProfile.MOS8580R5_WEAK: 6>
+    __members__: typing.ClassVar[
+        dict[str, ChipProfile]
+    ]  # value = {'MOS6581R2': <ChipProfile.MOS6581R2: 1>, 'MOS6581R2_STRONG': <ChipProfile.MOS6581R2_STRONG: 2>, 'MOS6581R3': <ChipProfile.MOS6581R3: 3>, 'MOS6581R4AR': <ChipProfile.MOS6581R4AR: 4>, 'MOS8580R5': <ChipProfile.MOS8580R5: 5>, 'MOS8580R5_WEAK': <ChipProfile.MOS8580R5_WEAK: 6>, 'MOS8580R5_STRONG': <ChipProfile.MOS8580R5_STRONG: 7>}
+    def __eq__(self, other: typing.Any) -> bool: ...
+    def __getstate__(self) -> int: ...
+    def __hash__(self) -> int: ...
+    def __index__(self) -> int: ...
+    def __init__(self, value: typing.SupportsInt) -> None: ...
+    def __int__(self) -> int: ...
+    def __ne__(self, other: typing.Any) -> bool: ...
+    def __repr__(self) -> str: ...
+    def __setstate__(self, state: typing.SupportsInt) -> None: ...
+    def __str__(self) -> str: ...
+    @property
+    def name(self) -> str: ...
+    @property
+    def value(self) -> int: ...
+
+class CombinedWaveforms:
+    """
+
+                   Strength of the combined waveforms.
+
+
+    Members:
+
+      AVERAGE :
+                   Average strength, as sampled from a 6581 R3 and an 8580 R5
+
+
+      WEAK :
+                   Weak strength, as sampled from a 6581 R2 and an 8580 R5
+
+
+      STRONG :
+                   Strong strength, as sampled from a 6581 R2 and an 8580 R5
+
+    """
+
+    AVERAGE: typing.ClassVar[CombinedWaveforms]  # value = <CombinedWaveforms.AVERAGE: 1>
+    STRONG: typing.ClassVar[CombinedWaveforms]  # value = <CombinedWaveforms.STRONG: 3>
+    WEAK: typing.ClassVar[CombinedWaveforms]  # value = <CombinedWaveforms.WEAK: 2>
+    __members__: typing.ClassVar[
+        dict[str, CombinedWaveforms]
+    ]  # value = {'AVERAGE': <CombinedWaveforms.AVERAGE: 1>, 'WEAK': <CombinedWaveforms.WEAK: 2>, 'STRONG': <CombinedWaveforms.STRONG: 3>}
+    def __eq__(self, other: typing.Any) -> bool: ...
+    def __getstate__(self) -> int: ...
+    def __hash__(self) -> int: ...
+    def __index__(self) -> int: ...
+    def __init__(self, value: typing.SupportsInt) -> None: ...
+    def __int__(self) -> int: ...
+    def __ne__(self, other: typing.Any) -> bool: ...
+    def __repr__(self) -> str: ...
+    def __setstate__(self, state: typing.SupportsInt) -> None: ...
+    def __str__(self) -> str: ...
+    @property
+    def name(self) -> str: ...
+    @property
+    def value(self) -> int: ...
+
+class Quality:
+    """
+
+                   Emulation quality levels.
+
+
+    Members:
+
+      REFERENCE :
+                   Full nonlinear filter model
+
+
+      FAST :
+                   Linearized filter model, not clocked once it holds still while the voices are idle
+
+
+      DRAFT :
+                   Linearized filter model clocked at half rate
+
+    """
+
+    DRAFT: typing.ClassVar[Quality]  # value = <Quality.DRAFT: 3>
+    FAST: typing.ClassVar[Quality]  # value = <Quality.FAST: 2>
+    REFERENCE: typing.ClassVar[Quality]  # value = <Quality.REFERENCE: 1>
+    __members__: typing.ClassVar[
+        dict[str, Quality]
+    ]  # value = {'REFERENCE': <Quality.REFERENCE: 1>, 'FAST': <Quality.FAST: 2>, 'DRAFT': <Quality.DRAFT: 3>}
+    def __eq__(self, other: typing.Any) -> bool: ...
+    def __getstate__(self) -> int: ...
+    def __hash__(self) -> int: ...
+    def __index__(self) -> int: ...
+    def __init__(self, value: typing.SupportsInt) -> None: ...
+    def __int__(self) -> int: ...
+    def __ne__(self, other: typing.Any) -> bool: ...
+    def __repr__(self) -> str: ...
+    def __setstate__(self, state: typing.SupportsInt) -> None: ...
+    def __str__(self) -> str: ...
+    @property
+    def name(self) -> str: ...
+    @property
+    def value(self) -> int: ...
+
 class SID:
     """
 
@@ -75,11 +223,9 @@ class SID:
         The default end of passband frequency is pass_freq = 0.9*sample_freq/2
         for sample frequencies up to ~ 44.1kHz, and 20kHz for higher sample frequencies.
 
-        For resampling, the ratio between the clock frequency and the sample frequency
-        is limited as follows: 125*clock_freq/sample_freq < 16384
-        E.g. provided a clock frequency of ~ 1MHz, the sample frequency can not be set
-        lower than ~ 8kHz. A lower sample frequency would make the resampling code
-        overfill its 16k sample ring buffer.
+        For resampling, low sample frequencies are reached by halving the rate
+        with short half-band filters before the SINC, whenever that is cheaper,
+        so sample frequencies of a few hundred Hz are supported as well.
 
         Args:
             chip_model (_pyresidfp.ChipModel):  Chip model to emulate
@@ -177,6 +323,18 @@ class SID:
             RuntimeError
         """
 
+    def set_chip_profile(self, profile: ChipProfile) -> None:
+        """
+        Set chip model, combined waveforms strength and filter settings at once.
+        Unlike setting the chip model, this doesn't reset the chip.
+
+        Args:
+            profile (_pyresidfp.ChipProfile): Chip profile to emulate
+
+        Raises:
+            RuntimeError
+        """
+
     def set_filter_6581_curve(self, curve_position: typing.SupportsFloat) -> None:
         """
         Set filter curve parameter for 6581 model.
@@ -185,6 +343,15 @@ class SID:
             curve_position (float): 0 .. 1, where 0 sets center frequency high ("light") and 1 sets it low ("dark"), default is 0.5
         """
 
+    def set_filter_6581_range(self, adjustment: typing.SupportsFloat) -> None:
+        """
+        Set filter range parameter for 6581 model.
+        Only affects this instance.
+
+        Args:
+            adjustment (float): 0 .. 1, where 0 sets center frequency low ("dark") and 1 sets it high ("bright"), default is 0.5
+        """
+
     def set_filter_8580_curve(self, curve_position: typing.SupportsFloat) -> None:
         """
         Set filter curve parameter for 8580 model.
@@ -211,6 +378,30 @@ class SID:
     @chip_model.setter
     def chip_model(self, arg1: ChipModel) -> None: ...
     @property
+    def combined_waveforms(self) -> CombinedWaveforms:
+        """
+        _pyresidfp.CombinedWaveforms: Strength of the combined waveforms
+        """
+
+    @combined_waveforms.setter
+    def combined_waveforms(self, arg1: CombinedWaveforms) -> None: ...
+    @property
+    def quality(self) -> Quality:
+        """
+        _pyresidfp.Quality: Emulation quality, trading filter accuracy for speed
+        """
+
+    @quality.setter
+    def quality(self, arg1: Quality) -> None: ...
+    @property
+    def compact_tables(self) -> bool:
+        """
+        bool: Use compact, interpolated filter tables, faster on CPUs with small caches
+        """
+
+    @compact_tables.setter
+    def compact_tables(self, arg1: bool) -> None: ...
+    @property
     def clock_frequency(self) -> float:
         """
         float: Clock frequency of chip to emulate
@@ -226,6 +417,38 @@ class SID:
 
     @sampling_frequency.setter
     def sampling_frequency(self, arg1: typing.SupportsFloat) -> None: ...
+    @property
+    def passband_frequency(self) -> float:
+        """
+        float: End of passband of the resampling filter, 0 for the default. A lower one is cheaper to compute
+        """
+
+    @passband_frequency.setter
+    def passband_frequency(self, arg1: typing.SupportsFloat) -> None: ...
+    @property
+    def dense_phase_tables(self) -> bool:
+        """
+        bool: Resample with dense phase tables, one convolution per sample instead of two,
+        faster as long as the few hundred KiB of tables stay in the cache
+        """
+
+    @dense_phase_tables.setter
+    def dense_phase_tables(self, arg1: bool) -> None: ...
+    @property
+    def ratio_adjustment(self) -> float:
+        """
+        float: Output sampling rate adjustment in parts per million, up to 1%, to follow the clock of a sound card.
+        Keeps the resampling filters and history, unlike changing the sampling frequency
+        """
+
+    @ratio_adjustment.setter
+    def ratio_adjustment(self, arg1: typing.SupportsFloat) -> None: ...
+    @property
+    def delay(self) -> float:
+        """
+        float: Delay of the output of the sampling method in seconds, at low frequencies
+        """
+
     @property
     def sampling_method(self) -> SamplingMethod:
         """
@@ -250,13 +473,18 @@ class SamplingMethod:
       RESAMPLE :
                    Two-pass resampling
 
+
+      RESAMPLE_MINIMUM_PHASE :
+                   Two-pass resampling with minimum phase filters, for a lower delay
+
     """
 
     DECIMATE: typing.ClassVar[SamplingMethod]  # value = <SamplingMethod.DECIMATE: 1>
     RESAMPLE: typing.ClassVar[SamplingMethod]  # value = <SamplingMethod.RESAMPLE: 2>
+    RESAMPLE_MINIMUM_PHASE: typing.ClassVar[SamplingMethod]  # value = <SamplingMethod.RESAMPLE_MINIMUM_PHASE: 3>
     __members__: typing.ClassVar[
         dict[str, SamplingMethod]
-    ]  # value = {'DECIMATE': <SamplingMethod.DECIMATE: 1>, 'RESAMPLE': <SamplingMethod.RESAMPLE: 2>}
+    ]  # value = {'DECIMATE': <SamplingMethod.DECIMATE: 1>, 'RESAMPLE': <SamplingMethod.RESAMPLE: 2>, 'RESAMPLE_MINIMUM_PHASE': <SamplingMethod.RESAMPLE_MINIMUM_PHASE: 3>}
     def __eq__(self, other: typing.Any) -> bool: ...
     def __getstate__(self) -> int: ...
     def __hash__(self) -> int: ...
@@ -272,4 +500,17 @@ class SamplingMethod:
     @property
     def value(self) -> int: ...
 
+def set_cache_directory(path: str) -> None:
+    """
+    Set the directory where the filter lookup tables are cached.
+
+    Building the tables takes a noticeable time at the first use of
+    each chip model. Once cached, later processes map the tables
+    read-only and share them. Only chip models first used afterwards
+    are affected.
+
+    Args:
+        path (str): Cache directory, empty to disable caching
+    """
+
 __version__: str = "0.16.1"
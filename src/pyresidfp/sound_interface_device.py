@@ -21,7 +21,14 @@ import logging
 import typing as t
 from enum import Enum
 
-from ._pyresidfp import ChipModel, SID, SamplingMethod
+from ._pyresidfp import (
+    ChipModel,
+    ChipProfile,
+    CombinedWaveforms,
+    Quality,
+    SID,
+    SamplingMethod,
+)
 from .musical_scale import Tone
 from .registers import ReadableRegister, WritableRegister
 
@@ -122,6 +129,7 @@ class SoundInterfaceDevice(metaclass=_Metaclass):
         sampling_method: t.Optional[SamplingMethod] = None,
         clock_frequency: t.Optional[float] = None,
         sampling_frequency: t.Optional[float] = None,
+        passband_frequency: t.Optional[float] = None,
     ) -> None:
         """Creates a new instance."""
         self._log = logging.getLogger(__name__)
@@ -130,10 +138,11 @@ class SoundInterfaceDevice(metaclass=_Metaclass):
         clock_frequency = clock_frequency or type(self).DEFAULT_CLOCK_FREQUENCY
         sampling_frequency = sampling_frequency or type(self).DEFAULT_SAMPLING_RATE
         assert 0 < sampling_frequency <= clock_frequency
-        assert 125.0 * clock_frequency / sampling_frequency < 16384.0
         self._sid = SID(
             chip_model, sampling_method, clock_frequency, sampling_frequency
         )
+        if passband_frequency:
+            self._sid.passband_frequency = passband_frequency
 
     @property
     def chip_model(self) -> ChipModel:
@@ -144,6 +153,31 @@ class SoundInterfaceDevice(metaclass=_Metaclass):
     def chip_model(self, value: ChipModel) -> None:
         self._sid.chip_model = value
 
+    def set_chip_profile(self, profile: ChipProfile) -> None:
+        """Sets chip model, combined waveforms strength and filter settings at once
+
+        Args:
+            profile: chip revision to emulate
+        """
+        self._sid.set_chip_profile(profile)
+
+    @property
+    def combined_waveforms(self) -> CombinedWaveforms:
+        """CombinedWaveforms: Strength of the combined waveforms"""
+        return self._sid.combined_waveforms
+
+    @combined_waveforms.setter
+    def combined_waveforms(self, value: CombinedWaveforms) -> None:
+        self._sid.combined_waveforms = value
+
+    def set_filter_6581_range(self, adjustment: float) -> None:
+        """Sets the filter range of the 6581 model
+
+        Args:
+            adjustment: 0 .. 1, where 0 sets center frequency low ("dark") and 1 sets it high ("bright")
+        """
+        self._sid.set_filter_6581_range(adjustment)
+
     @property
     def sampling_method(self) -> SamplingMethod:
         """SamplingMethod: Method to use for sampling"""
@@ -153,6 +187,24 @@ class SoundInterfaceDevice(metaclass=_Metaclass):
     def sampling_method(self, value: SamplingMethod) -> None:
         self._sid.sampling_method = value
 
+    @property
+    def quality(self) -> Quality:
+        """Quality: Emulation quality, trading filter accuracy for speed"""
+        return self._sid.quality
+
+    @quality.setter
+    def quality(self, value: Quality) -> None:
+        self._sid.quality = value
+
+    @property
+    def compact_tables(self) -> bool:
+        """bool: Use compact, interpolated filter tables, faster on CPUs with small caches"""
+        return self._sid.compact_tables
+
+    @compact_tables.setter
+    def compact_tables(self, value: bool) -> None:
+        self._sid.compact_tables = value
+
     @property
     def clock_frequency(self) -> float:
         """float: System clock frequency"""
@@ -171,6 +223,38 @@ class SoundInterfaceDevice(metaclass=_Metaclass):
     def sampling_frequency(self, value: float) -> None:
         self._sid.sampling_frequency = value
 
+    @property
+    def passband_frequency(self) -> float:
+        """float: End of passband of the resampling filter, 0 for the default"""
+        return self._sid.passband_frequency
+
+    @passband_frequency.setter
+    def passband_frequency(self, value: float) -> None:
+        self._sid.passband_frequency = value
+
+    @property
+    def dense_phase_tables(self) -> bool:
+        """bool: Resample with dense phase tables, faster when they fit in the cache"""
+        return self._sid.dense_phase_tables
+
+    @dense_phase_tables.setter
+    def dense_phase_tables(self, value: bool) -> None:
+        self._sid.dense_phase_tables = value
+
+    @property
+    def ratio_adjustment(self) -> float:
+        """float: Output sampling rate adjustment in parts per million"""
+        return self._sid.ratio_adjustment
+
+    @ratio_adjustment.setter
+    def ratio_adjustment(self, value: float) -> None:
+        self._sid.ratio_adjustment = value
+
+    @property
+    def delay(self) -> datetime.timedelta:
+        """datetime.timedelta: Delay of the output of the sampling method"""
+        return datetime.timedelta(seconds=self._sid.delay)
+
     def reset(self):
         """Resets the emulation."""
         self._sid.reset()
@@ -129,6 +129,12 @@ public:
      */
     unsigned int output() const { return envelope_counter; }
 
+    /**
+     * Check whether the envelope counter is frozen,
+     * it can only be released by a register write.
+     */
+    bool isFrozen() const { return !counter_enabled && (state_pipeline == 0); }
+
     /**
      * SID reset.
      */
@@ -84,6 +84,18 @@ public:
      */
     int clock(int input);
 
+    /**
+     * Check whether the filter is at its fixed point for a constant input,
+     * so that clocking it doesn't change its state or its output anymore.
+     *
+     * @param input input sample, signed 16 bit
+     */
+    bool isSettled(int input) const
+    {
+        const int Vi = input << 11;
+        return ((w0lp_1_s7 * (Vi - Vlp) >> 7) == 0) && ((w0hp_1_s17 * (Vlp - Vhp) >> 17) == 0);
+    }
+
     /**
      * Constructor.
      */
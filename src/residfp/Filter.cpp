@@ -50,7 +50,7 @@ static constexpr int mixerIdx[8] =
 
 void Filter::updateMixing()
 {
-    currentVolume = volume + (vol * (1<<16));
+    currentVolume = compact ? compact->volume[vol] : volume + (vol * (1<<16));
 
     unsigned int Nsum = 0;
     unsigned int Nmix = 0;
@@ -63,13 +63,13 @@ void Filter::updateMixing()
 
     (filtE ? Nsum : Nmix)++;
 
-    currentSummer = summer + summerIdx[Nsum];
+    currentSummer = compact ? compact->summer[Nsum] : summer + summerIdx[Nsum];
 
     if (lp) Nmix++;
     if (bp) Nmix++;
     if (hp) Nmix++;
 
-    currentMixer = mixer + mixerIdx[Nmix];
+    currentMixer = compact ? compact->mixer[Nmix] : mixer + mixerIdx[Nmix];
 }
 
 void Filter::writeFC_LO(unsigned char fc_lo)
@@ -136,6 +136,42 @@ void Filter::enable(bool enable)
     }
 }
 
+void Filter::setQuality(Quality quality)
+{
+    this->quality = quality;
+    skipCycle = false;
+    updateCenterFrequency();
+}
+
+void Filter::setCompactTables(bool enable)
+{
+    compact = enable ? &fmc.getCompactTables() : nullptr;
+    updateResonance((filt >> 4) & 0x0f);
+    updateMixing();
+}
+
+bool Filter::State::operator==(const State& other) const
+{
+    return (Vhp == other.Vhp) && (Vbp == other.Vbp) && (Vlp == other.Vlp)
+        && (integrator[0][0] == other.integrator[0][0]) && (integrator[0][1] == other.integrator[0][1])
+        && (integrator[1][0] == other.integrator[1][0]) && (integrator[1][1] == other.integrator[1][1])
+        && (ditherPos == other.ditherPos) && (lastOutput == other.lastOutput) && (skipCycle == other.skipCycle);
+}
+
+Filter::State Filter::getState() const
+{
+    State state;
+    state.Vhp = Vhp;
+    state.Vbp = Vbp;
+    state.Vlp = Vlp;
+    getIntegratorState(state.integrator);
+    // The dither only depends on the position in its sequence
+    state.ditherPos = ditherPos & (FilterModelConfig::DITHER_PERIOD - 1);
+    state.lastOutput = lastOutput;
+    state.skipCycle = skipCycle;
+    return state;
+}
+
 void Filter::reset()
 {
     writeFC_LO(0);
@@ -37,24 +37,27 @@ namespace reSIDfp
 class Filter
 {
 private:
-    unsigned short* mixer;
-    unsigned short* summer;
-    unsigned short* resonance;
-    unsigned short* volume;
+    const unsigned short* mixer;
+    const unsigned short* summer;
+    const unsigned short* resonance;
+    const unsigned short* volume;
 
     FilterModelConfig& fmc;
 
+    /// Compact tables, null when using the full tables.
+    const FilterModelConfig::CompactTables* compact = nullptr;
+
     /// Current filter/voice mixer setting.
-    unsigned short* currentMixer = nullptr;
+    const unsigned short* currentMixer = nullptr;
 
     /// Filter input summer setting.
-    unsigned short* currentSummer = nullptr;
+    const unsigned short* currentSummer = nullptr;
 
     /// Filter resonance value.
-    unsigned short* currentResonance = nullptr;
+    const unsigned short* currentResonance = nullptr;
 
     /// Current volume amplifier setting.
-    unsigned short* currentVolume = nullptr;
+    const unsigned short* currentVolume = nullptr;
 
 protected:
     /// Filter highpass state.
@@ -102,10 +105,32 @@ private:
     /// Selects which inputs to route through filter.
     unsigned char filt = 0;
 
+    /// Emulation quality.
+    Quality quality = REFERENCE;
+
+    /// Skip the analog stages on this cycle, for #DRAFT quality.
+    bool skipCycle = false;
+
+    /// Output of the last computed cycle.
+    unsigned short lastOutput = 0;
+
+    /// Position in the dither sequence of the voice inputs.
+    unsigned int ditherPos = 0;
+
 private:
-    inline int getNormalizedVoice(Voice& v) const
+    /**
+     * Look up a compact table with linear interpolation.
+     */
+    static inline int interpolate(const unsigned short* table, int x)
+    {
+        const int i = x >> FilterModelConfig::COMPACT_SHIFT;
+        const int frac = x & ((1 << FilterModelConfig::COMPACT_SHIFT) - 1);
+        return table[i] + (((table[i + 1] - table[i]) * frac) >> FilterModelConfig::COMPACT_SHIFT);
+    }
+
+    inline int getNormalizedVoice(Voice& v)
     {
-        return fmc.getNormalizedVoice(v.output(), v.envelope()->output());
+        return fmc.getNormalizedVoice(v.output(), v.envelope()->output(), ++ditherPos);
     }
 
     // If voice 3 is off we still need to clock the waveform generator
@@ -115,6 +140,16 @@ private:
         return 0;
     }
 
+    inline int getNormalizedVoice(Voice& v, unsigned int wav)
+    {
+        return fmc.getNormalizedVoice(v.output(wav), v.envelope()->output(), ++ditherPos);
+    }
+
+    /**
+     * Route the normalized voices through the filter and the mixer.
+     */
+    unsigned short mix(int V1, int V2, int V3);
+
 protected:
     /**
      * Update filter cutoff frequency.
@@ -126,7 +161,10 @@ protected:
      *
      * @param res the new resonance value
      */
-    void updateResonance(unsigned char res) { currentResonance = resonance + (res * (1<<16)); }
+    void updateResonance(unsigned char res)
+    {
+        currentResonance = compact ? compact->resonance[res] : resonance + (res * (1<<16));
+    }
 
     /**
      * Mixing configuration modified (offsets change)
@@ -138,8 +176,41 @@ protected:
      */
     inline unsigned int getFC() const { return fc; }
 
+    /**
+     * Get the emulation quality.
+     */
+    inline Quality getQuality() const { return quality; }
+
+    /**
+     * Get the number of cycles covered by each integrator step.
+     */
+    inline int getCyclesPerStep() const { return quality == DRAFT ? 2 : 1; }
+
     virtual int solveIntegrators() = 0;
 
+    /**
+     * Get the state of the integrators in use, vx and vc of each.
+     */
+    virtual void getIntegratorState(int state[2][2]) const = 0;
+
+public:
+    /**
+     * Everything that, along with constant inputs,
+     * determines the following outputs of the filter.
+     */
+    struct State
+    {
+        int Vhp;
+        int Vbp;
+        int Vlp;
+        int integrator[2][2];
+        unsigned int ditherPos; ///< position in the dither sequence
+        unsigned short lastOutput;
+        bool skipCycle;
+
+        bool operator==(const State& other) const;
+    };
+
 public:
     Filter(FilterModelConfig& fmc);
 
@@ -155,6 +226,27 @@ public:
      */
     unsigned short clock(Voice& v1, Voice& v2, Voice& v3);
 
+    /**
+     * SID clocking - 1 cycle, with precomputed waveform outputs.
+     *
+     * @param v1 voice 1 in
+     * @param v2 voice 2 in
+     * @param v3 voice 3 in
+     * @param wav1 voice 1 waveform output
+     * @param wav2 voice 2 waveform output
+     * @param wav3 voice 3 waveform output
+     * @return filtered output, unsigned 16 bit
+     * @see WaveformGenerator::outputBlock
+     */
+    unsigned short clock(Voice& v1, Voice& v2, Voice& v3,
+        unsigned int wav1, unsigned int wav2, unsigned int wav3);
+
+    /**
+     * Get the current state, e.g. to find out whether
+     * the filter has settled at a fixed point.
+     */
+    State getState() const;
+
     /**
      * Enable filter.
      *
@@ -167,6 +259,21 @@ public:
      */
     void reset();
 
+    /**
+     * Set the emulation quality.
+     *
+     * @param quality the quality level
+     */
+    void setQuality(Quality quality);
+
+    /**
+     * Use the compact gain and summer tables, which are sampled
+     * more coarsely and linearly interpolated, instead of the full ones.
+     *
+     * @param enable true to use the compact tables
+     */
+    void setCompactTables(bool enable);
+
     /**
      * Write Frequency Cutoff Low register.
      *
@@ -198,9 +305,12 @@ public:
     /**
      * Apply a signal to EXT-IN
      *
+     * This is a one-off normalization with a fixed dither position,
+     * so that resyncing the filter doesn't shift the dither of the voices.
+     *
      * @param input a signed 16 bit sample
      */
-    void input(short input) { Ve = fmc.getNormalizedVoice(input/32768.f, 0); }
+    void input(short input) { Ve = fmc.getNormalizedVoice(input/32768.f, 0, 0); }
 };
 
 } // namespace reSIDfp
@@ -213,11 +323,43 @@ namespace reSIDfp
 RESID_INLINE
 unsigned short Filter::clock(Voice& voice1, Voice& voice2, Voice& voice3)
 {
+    if (unlikely(quality == DRAFT) && (skipCycle = !skipCycle))
+    {
+        // The waveform generators must be clocked anyway
+        voice1.wave()->output();
+        voice2.wave()->output();
+        voice3.wave()->output();
+        return lastOutput;
+    }
+
     const int V1 = getNormalizedVoice(voice1);
     const int V2 = getNormalizedVoice(voice2);
     // Voice 3 is silenced by voice3off if it is not routed through the filter.
     const int V3 = (filt3 || !voice3off) ? getNormalizedVoice(voice3) : getSilentVoice(voice3);
 
+    return mix(V1, V2, V3);
+}
+
+RESID_INLINE
+unsigned short Filter::clock(Voice& voice1, Voice& voice2, Voice& voice3,
+    unsigned int wav1, unsigned int wav2, unsigned int wav3)
+{
+    if (unlikely(quality == DRAFT) && (skipCycle = !skipCycle))
+    {
+        return lastOutput;
+    }
+
+    const int V1 = getNormalizedVoice(voice1, wav1);
+    const int V2 = getNormalizedVoice(voice2, wav2);
+    // Voice 3 is silenced by voice3off if it is not routed through the filter.
+    const int V3 = (filt3 || !voice3off) ? getNormalizedVoice(voice3, wav3) : 0;
+
+    return mix(V1, V2, V3);
+}
+
+RESID_INLINE
+unsigned short Filter::mix(int V1, int V2, int V3)
+{
     int Vsum = 0;
     int Vmix = 0;
 
@@ -226,11 +368,20 @@ unsigned short Filter::clock(Voice& voice1, Voice& voice2, Voice& voice3)
     (filt3 ? Vsum : Vmix) += V3;
     (filtE ? Vsum : Vmix) += Ve;
 
-    Vhp = currentSummer[currentResonance[Vbp] + Vlp + Vsum];
+    if (likely(compact == nullptr))
+    {
+        Vhp = currentSummer[currentResonance[Vbp] + Vlp + Vsum];
+
+        Vmix += solveIntegrators();
+
+        return lastOutput = currentVolume[currentMixer[Vmix]];
+    }
+
+    Vhp = interpolate(currentSummer, interpolate(currentResonance, Vbp) + Vlp + Vsum);
 
     Vmix += solveIntegrators();
 
-    return currentVolume[currentMixer[Vmix]];
+    return lastOutput = interpolate(currentVolume, interpolate(currentMixer, Vmix));
 }
 
 } // namespace reSIDfp
@@ -24,6 +24,7 @@
 
 #include "Integrator6581.h"
 
+#include <algorithm>
 #include <cassert>
 
 namespace reSIDfp
@@ -31,8 +32,16 @@ namespace reSIDfp
 
 int Filter6581::solveIntegrators()
 {
-    Vbp = hpIntegrator.solve(Vhp);
-    Vlp = bpIntegrator.solve(Vbp);
+    if (likely(getQuality() == REFERENCE))
+    {
+        Vbp = hpIntegrator.solve(Vhp);
+        Vlp = bpIntegrator.solve(Vbp);
+    }
+    else
+    {
+        Vbp = hpLinear.solve(Vhp);
+        Vlp = bpLinear.solve(Vbp);
+    }
 
     int Vfilt = 0;
     if (lp) Vfilt += Vlp;
@@ -48,28 +57,69 @@ int Filter6581::solveIntegrators()
     return (Vfilt * filterGain + offset) >> 12;
 }
 
-Filter6581::~Filter6581()
+void Filter6581::getIntegratorState(int state[2][2]) const
 {
-    delete [] f0_dac;
+    if (likely(getQuality() == REFERENCE))
+    {
+        hpIntegrator.getState(state[0]);
+        bpIntegrator.getState(state[1]);
+    }
+    else
+    {
+        hpLinear.getState(state[0]);
+        bpLinear.getState(state[1]);
+    }
 }
 
 void Filter6581::updateCenterFrequency()
 {
-    const unsigned short Vw = f0_dac[getFC()];
+    const int lo = (*dacLo)[getFC()];
+    const int hi = (*dacHi)[getFC()];
+    const unsigned short Vw = static_cast<unsigned short>(lo + (((hi - lo) * curveWeight) >> 8));
     hpIntegrator.setVw(Vw);
     bpIntegrator.setVw(Vw);
+
+    if (getQuality() != REFERENCE)
+    {
+        // Both integrators share the same VCR gate voltage
+        const double gain = hpIntegrator.getLinearGain(hpLinear.getWorkingPoint()) * getCyclesPerStep();
+        hpLinear.setGain(gain);
+        bpLinear.setGain(gain);
+    }
 }
 
 void Filter6581::setFilterCurve(double curvePosition)
 {
-    delete [] f0_dac;
-    f0_dac = FilterModelConfig6581::getInstance()->getDAC(curvePosition);
+    // clamp into allowed range
+#ifdef HAVE_CXX17
+    curvePosition = std::clamp(curvePosition, 0.0, 1.0);
+#else
+    curvePosition = std::max(std::min(curvePosition, 1.0), 0.);
+#endif
+
+    const double position = curvePosition * FilterModelConfig6581::CURVE_STEPS;
+    int lo = static_cast<int>(position);
+    curveWeight = static_cast<int>((position - lo) * (1 << 8) + 0.5);
+    if (curveWeight == (1 << 8))
+    {
+        lo++;
+        curveWeight = 0;
+    }
+
+    FilterModelConfig6581* const fmc = FilterModelConfig6581::getInstance();
+    dacLo = fmc->getDAC(lo);
+    dacHi = (curveWeight != 0) ? fmc->getDAC(lo + 1) : dacLo;
+
     updateCenterFrequency();
 }
 
 void Filter6581::setFilterRange(double adjustment)
 {
-    FilterModelConfig6581::getInstance()->setFilterRange(adjustment);
+    const double uCox = FilterModelConfig6581::getUCox(adjustment);
+    hpIntegrator.setUCox(uCox);
+    bpIntegrator.setUCox(uCox);
+
+    updateCenterFrequency();
 }
 
 } // namespace reSIDfp
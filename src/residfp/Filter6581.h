@@ -26,6 +26,7 @@
 #include "Filter.h"
 #include "FilterModelConfig6581.h"
 #include "Integrator6581.h"
+#include "IntegratorLinear.h"
 
 #include "sidcxx11.h"
 
@@ -326,7 +327,20 @@ private:
     /// VCR + associated capacitor connected to bandpass output.
     Integrator6581 bpIntegrator;
 
-    const unsigned short* f0_dac;
+    /// Linearized integrators, for the faster quality levels.
+    //@{
+    IntegratorLinear hpLinear;
+    IntegratorLinear bpLinear;
+    //@}
+
+    /// DAC tables of the quantized curve positions around the current one.
+    //@{
+    FilterModelConfig6581::DacTable dacLo;
+    FilterModelConfig6581::DacTable dacHi;
+    //@}
+
+    /// Weight of #dacHi, scaled by 2^8.
+    int curveWeight = 0;
 
 protected:
     /**
@@ -336,18 +350,23 @@ protected:
 
     int solveIntegrators() override;
 
+    void getIntegratorState(int state[2][2]) const override;
+
 public:
     Filter6581() :
         Filter(*FilterModelConfig6581::getInstance()),
         hpIntegrator(*FilterModelConfig6581::getInstance()),
         bpIntegrator(*FilterModelConfig6581::getInstance()),
-        f0_dac(FilterModelConfig6581::getInstance()->getDAC(0.5))
-    {}
-
-    ~Filter6581() override;
+        hpLinear(*FilterModelConfig6581::getInstance()),
+        bpLinear(*FilterModelConfig6581::getInstance())
+    {
+        setFilterCurve(0.5);
+    }
 
     /**
      * Set filter curve type based on single parameter.
+     * Cheap enough to be automated, as the DAC tables of the
+     * quantized curve positions are cached and interpolated.
      *
      * @param curvePosition 0 .. 1, where 0 sets center frequency high ("bright") and 1 sets it low ("dark").
      *                      Default is 0.5
@@ -359,6 +378,7 @@ public:
      *
      * @param adjustment 0 .. 1, where 0 sets center frequency low ("dark"), 1 sets it high ("bright").
      *                   This also affects the range. Default is 0.5
+     *                   Only affects this filter, the lookup tables are shared.
      */
     void setFilterRange(double adjustment);
 };
@@ -29,8 +29,16 @@ namespace reSIDfp
 
 int Filter8580::solveIntegrators()
 {
-    Vbp = hpIntegrator.solve(Vhp);
-    Vlp = bpIntegrator.solve(Vbp);
+    if (likely(getQuality() == REFERENCE))
+    {
+        Vbp = hpIntegrator.solve(Vhp);
+        Vlp = bpIntegrator.solve(Vbp);
+    }
+    else
+    {
+        Vbp = hpLinear.solve(Vhp);
+        Vlp = bpLinear.solve(Vbp);
+    }
 
     int Vfilt = 0;
     if (lp) Vfilt += Vlp;
@@ -40,39 +48,29 @@ int Filter8580::solveIntegrators()
     return Vfilt;
 }
 
-/**
- * W/L ratio of frequency DAC bit 0,
- * other bit are proportional.
- * When no bit are selected a resistance with half
- * W/L ratio is selected.
- */
-const double DAC_WL0 = 0.00615;
-
 Filter8580::~Filter8580() = default;
 
-void Filter8580::updateCenterFrequency()
+void Filter8580::getIntegratorState(int state[2][2]) const
 {
-    double wl;
-    double dacWL = DAC_WL0;
-    if (getFC())
+    if (likely(getQuality() == REFERENCE))
     {
-        wl = 0.;
-        for (unsigned int i = 0; i < 11; i++)
-        {
-            if (getFC() & (1 << i))
-            {
-                wl += dacWL;
-            }
-            dacWL *= 2.;
-        }
+        hpIntegrator.getState(state[0]);
+        bpIntegrator.getState(state[1]);
     }
     else
     {
-        wl = dacWL/2.;
+        hpLinear.getState(state[0]);
+        bpLinear.getState(state[1]);
     }
+}
 
-    hpIntegrator.setFc(wl);
-    bpIntegrator.setFc(wl);
+void Filter8580::updateCenterFrequency()
+{
+    const unsigned short n_dac = FilterModelConfig8580::getInstance()->getDacCurrentFactor(getFC());
+    hpIntegrator.setFc(n_dac);
+    bpIntegrator.setFc(n_dac);
+
+    updateLinearGain();
 }
 
 void Filter8580::setFilterCurve(double curvePosition)
@@ -83,6 +81,19 @@ void Filter8580::setFilterCurve(double curvePosition)
 
     hpIntegrator.setV(cp);
     bpIntegrator.setV(cp);
+
+    updateLinearGain();
+}
+
+void Filter8580::updateLinearGain()
+{
+    if (getQuality() != REFERENCE)
+    {
+        // Both integrators share the same DAC setting
+        const double gain = hpIntegrator.getLinearGain(hpLinear.getWorkingPoint()) * getCyclesPerStep();
+        hpLinear.setGain(gain);
+        bpLinear.setGain(gain);
+    }
 }
 
 } // namespace reSIDfp
@@ -26,6 +26,7 @@
 #include "Filter.h"
 #include "FilterModelConfig8580.h"
 #include "Integrator8580.h"
+#include "IntegratorLinear.h"
 
 #include "sidcxx11.h"
 
@@ -283,8 +284,20 @@ private:
     /// VCR + associated capacitor connected to bandpass output.
     Integrator8580 bpIntegrator;
 
+    /// Linearized integrators, for the faster quality levels.
+    //@{
+    IntegratorLinear hpLinear;
+    IntegratorLinear bpLinear;
+    //@}
+
     double cp;
 
+private:
+    /**
+     * Calibrate the linearized integrators.
+     */
+    void updateLinearGain();
+
 protected:
     /**
      * Set filter cutoff frequency.
@@ -293,11 +306,15 @@ protected:
 
     int solveIntegrators() override;
 
+    void getIntegratorState(int state[2][2]) const override;
+
 public:
     Filter8580() :
         Filter(*FilterModelConfig8580::getInstance()),
         hpIntegrator(*FilterModelConfig8580::getInstance()),
-        bpIntegrator(*FilterModelConfig8580::getInstance())
+        bpIntegrator(*FilterModelConfig8580::getInstance()),
+        hpLinear(*FilterModelConfig8580::getInstance()),
+        bpLinear(*FilterModelConfig8580::getInstance())
     {
         setFilterCurve(0.5);
     }
@@ -22,12 +22,27 @@
 
 #include "FilterModelConfig.h"
 
+#include <atomic>
+#include <thread>
 #include <vector>
 #include <cstdint>
+#include <cstring>
 
 namespace reSIDfp
 {
 
+namespace
+{
+
+/// Size of the common tables in bytes, including opamp_rev.
+constexpr std::size_t TABLES_SIZE = sizeof(unsigned short) *
+    ((1 << 16) + FilterModelConfig::summer_offset<5>::value + FilterModelConfig::mixer_offset<8>::value + 2 * 16 * (1 << 16));
+
+/// Offset of the model specific tables, aligned for any table type.
+constexpr std::size_t EXTRA_TABLES_OFFSET = (TABLES_SIZE + 7) & ~static_cast<std::size_t>(7);
+
+}
+
 FilterModelConfig::FilterModelConfig(
     double vvr,
     double c,
@@ -35,24 +50,41 @@ FilterModelConfig::FilterModelConfig(
     double vth,
     double ucox,
     const Spline::Point *opamp_voltage,
-    int opamp_size
+    int opamp_size,
+    const char* name,
+    std::size_t extraSize
 ) :
     C(c),
     Vdd(vdd),
     Vth(vth),
     Vddt(Vdd - Vth),
+    uCox(ucox),
     vmin(opamp_voltage[0].x),
     vmax(std::max(Vddt, opamp_voltage[0].y)),
     denorm(vmax - vmin),
     norm(1.0 / denorm),
     N16(norm * UINT16_MAX),
     voice_voltage_range(vvr),
-    mixer(new unsigned short[mixer_offset<8>::value]),
-    summer(new unsigned short[summer_offset<5>::value]),
-    volume(new unsigned short[16 * (1 << 16)]),
-    resonance(new unsigned short[16 * (1 << 16)])
+    currFactorCoeff(denorm * (uCox / 2. * 1.0e-6 / C))
 {
-    setUCox(ucox);
+    // The tables depend only on the parameters below
+    // and on the model specific code
+    std::uint64_t key = FilterTableCache::hash(name, std::strlen(name));
+    const double params[4] = { vvr, c, vdd, vth };
+    key = FilterTableCache::hash(params, sizeof(params), key);
+    key = FilterTableCache::hash(opamp_voltage, opamp_size * sizeof(Spline::Point), key);
+
+    cache.reset(new FilterTableCache(name, key, EXTRA_TABLES_OFFSET + extraSize));
+
+    unsigned short* tables = reinterpret_cast<unsigned short*>(cache->getData());
+    opamp_rev = tables;
+    summer = opamp_rev + (1 << 16);
+    mixer = summer + summer_offset<5>::value;
+    volume = mixer + mixer_offset<8>::value;
+    resonance = volume + 16 * (1 << 16);
+
+    if (tablesCached())
+        return;
 
     // Convert op-amp voltage transfer to 16 bit values.
 
@@ -79,18 +111,136 @@ FilterModelConfig::FilterModelConfig(
     }
 }
 
-FilterModelConfig::~FilterModelConfig()
+FilterModelConfig::~FilterModelConfig() = default;
+
+void FilterModelConfig::buildTables(
+    const Spline::Point *opamp_voltage,
+    int opamp_size,
+    double nRatio,
+    double nDivisor,
+    const double resonance_n[16],
+    std::vector<std::function<void()>> extraJobs)
 {
-    delete [] mixer;
-    delete [] summer;
-    delete [] volume;
-    delete [] resonance;
+    const std::vector<Spline::Point> voltages(opamp_voltage, opamp_voltage + opamp_size);
+
+    auto opamp = [this, &voltages]
+    {
+        return OpAmp(voltages, Vddt, vmin, vmax);
+    };
+
+    // Largest jobs first, so that the pool drains evenly
+    std::vector<std::function<void()>> jobs;
+
+    for (int i = 7; i >= 0; i--)
+    {
+        jobs.emplace_back([this, &opamp, nRatio, i] { buildMixerTable(opamp(), nRatio, i); });
+        if (i < 5)
+            jobs.emplace_back([this, &opamp, i] { buildSummerTable(opamp(), i); });
+    }
+
+    for (auto& job : extraJobs)
+    {
+        jobs.push_back(std::move(job));
+    }
+
+    for (int n8 = 0; n8 < 16; n8++)
+    {
+        jobs.emplace_back([this, &opamp, nDivisor, n8] { buildVolumeTable(opamp(), nDivisor, n8); });
+        jobs.emplace_back([this, &opamp, resonance_n, n8] { buildResonanceTable(opamp(), resonance_n[n8], n8); });
+    }
+
+    std::atomic<std::size_t> next(0);
+
+    auto worker = [&jobs, &next]
+    {
+        for (std::size_t i = next++; i < jobs.size(); i = next++)
+        {
+            jobs[i]();
+        }
+    };
+
+#if defined(HAVE_CXX20) && defined(__cpp_lib_jthread)
+    using sidThread = std::jthread;
+#else
+    using sidThread = std::thread;
+#endif
+
+    // The calling thread works too
+    const unsigned int threads = std::min<std::size_t>(std::max(std::thread::hardware_concurrency(), 1u), jobs.size());
+
+    std::vector<sidThread> pool;
+    for (unsigned int i = 1; i < threads; i++)
+    {
+        pool.emplace_back(worker);
+    }
+
+    worker();
+
+    for (auto& thd : pool)
+    {
+        thd.join();
+    }
+}
+
+const FilterModelConfig::CompactTables& FilterModelConfig::getCompactTables()
+{
+    std::call_once(compactOnce, [this]
+    {
+        constexpr int step = 1 << COMPACT_SHIFT;
+
+        // Sample count of a sub-table with the given size,
+        // plus one for the interpolation of the last interval
+        auto compactSize = [](int size) { return ((size + step - 1) >> COMPACT_SHIFT) + 1; };
+
+        std::size_t total = 0;
+        for (int i = 0; i < 5; i++)
+            total += compactSize((2 + i) << 16);
+        for (int i = 0; i < 8; i++)
+            total += compactSize((i == 0) ? 1 : i << 16);
+        total += 2 * 16 * compactSize(1 << 16);
+
+        compactData.resize(total);
+        unsigned short* dst = compactData.data();
+
+        auto sample = [&dst, &compactSize](const unsigned short* table, int size)
+        {
+            const unsigned short* sub = dst;
+            for (int i = 0; i < compactSize(size); i++)
+            {
+                *dst++ = table[std::min(i * step, size - 1)];
+            }
+            return sub;
+        };
+
+        const unsigned short* src = summer;
+        for (int i = 0; i < 5; i++)
+        {
+            const int size = (2 + i) << 16;
+            compact.summer[i] = sample(src, size);
+            src += size;
+        }
+
+        src = mixer;
+        for (int i = 0; i < 8; i++)
+        {
+            const int size = (i == 0) ? 1 : i << 16;
+            compact.mixer[i] = sample(src, size);
+            src += size;
+        }
+
+        for (int n8 = 0; n8 < 16; n8++)
+        {
+            compact.volume[n8] = sample(volume + (n8 << 16), 1 << 16);
+            compact.resonance[n8] = sample(resonance + (n8 << 16), 1 << 16);
+        }
+    });
+
+    return compact;
 }
 
-void FilterModelConfig::setUCox(double new_uCox)
+unsigned char* FilterModelConfig::getExtraTables()
 {
-    uCox = new_uCox;
-    currFactorCoeff = denorm * (uCox / 2. * 1.0e-6 / C);
+    return cache->getData() + EXTRA_TABLES_OFFSET;
 }
 
 } // namespace reSIDfp
@@ -24,10 +24,16 @@
 #define FILTERMODELCONFIG_H
 
 #include <algorithm>
+#include <functional>
+#include <memory>
+#include <mutex>
 #include <random>
 #include <cassert>
 #include <climits>
+#include <cstddef>
+#include <vector>
 
+#include "FilterTableCache.h"
 #include "OpAmp.h"
 #include "Spline.h"
 
@@ -39,6 +45,26 @@ namespace reSIDfp
 class FilterModelConfig
 {
 public:
+    /// Log2 of the sampling step of the compact tables.
+    static constexpr int COMPACT_SHIFT = 4;
+
+    /// Length of the dither sequence, a power of 2
+    static constexpr unsigned int DITHER_PERIOD = 1024;
+
+    /**
+     * The gain and summer tables sampled every 2^COMPACT_SHIFT entries,
+     * for linear interpolation.
+     * The sub-tables in use are small enough for the working set of the
+     * filter to fit in a small L2 cache.
+     */
+    struct CompactTables
+    {
+        const unsigned short* summer[5];
+        const unsigned short* mixer[8];
+        const unsigned short* volume[16];
+        const unsigned short* resonance[16];
+    };
+
     // The highpass summer has 2 - 6 inputs (bandpass, lowpass, and 0 - 4 voices).
     template<int i>
     struct summer_offset
@@ -80,17 +106,16 @@ private:
     class Randomnoise
     {
     private:
-        double buffer[1024];
-        mutable int index = 0;
+        double buffer[DITHER_PERIOD];
     public:
         Randomnoise()
         {
             std::uniform_real_distribution<double> unif(0., 1.);
             std::default_random_engine re;
-            for (int i=0; i<1024; i++)
+            for (unsigned int i=0; i<DITHER_PERIOD; i++)
                 buffer[i] = unif(re);
         }
-        double getNoise() const { index = (index + 1) & 0x3ff; return buffer[index]; }
+        double getNoise(unsigned int pos) const { return buffer[pos & (DITHER_PERIOD - 1)]; }
     };
 
 protected:
@@ -105,7 +130,7 @@ protected:
     const double Vdd;           ///< Positive supply voltage
     const double Vth;           ///< Threshold voltage
     const double Vddt;          ///< Vdd - Vth
-    double uCox;                ///< Transconductance coefficient: u*Cox
+    const double uCox;          ///< Default transconductance coefficient: u*Cox
     //@}
 
     // Derived stuff
@@ -118,7 +143,10 @@ protected:
     const double voice_voltage_range;
 
     /// Current factor coefficient for op-amp integrators.
-    double currFactorCoeff;
+    const double currFactorCoeff;
+
+    /// Storage for all the lookup tables.
+    std::unique_ptr<FilterTableCache> cache;
 
     /// Lookup tables for gain and summer op-amps in output stage / filter.
     //@{
@@ -129,11 +157,18 @@ protected:
     //@}
 
     /// Reverse op-amp transfer function.
-    unsigned short opamp_rev[1 << 16]; //-V730_NOINIT this is initialized in the derived class constructor
+    unsigned short* opamp_rev;
 
 private:
     Randomnoise rnd;
 
+    /// Storage for the compact tables, built on first use.
+    //@{
+    std::once_flag compactOnce;
+    std::vector<unsigned short> compactData;
+    CompactTables compact;
+    //@}
+
 private:
     FilterModelConfig(const FilterModelConfig&) = delete;
     FilterModelConfig& operator= (const FilterModelConfig&) = delete;
@@ -152,6 +187,8 @@ protected:
      * @param ucox u*Cox
      * @param opamp_voltage opamp voltage array
      * @param opamp_size opamp voltage array size
+     * @param name model name, for the table cache
+     * @param extraSize size in bytes of the model specific tables
      */
     FilterModelConfig(
         double vvr,
@@ -160,15 +197,54 @@ protected:
         double vth,
         double ucox,
         const Spline::Point *opamp_voltage,
-        int opamp_size
+        int opamp_size,
+        const char* name,
+        std::size_t extraSize
     );
 
     ~FilterModelConfig();
 
-    void setUCox(double new_uCox);
+    /**
+     * Check whether the tables were loaded from the cache,
+     * in which case they must not be built again.
+     */
+    bool tablesCached() const { return cache->isLoaded(); }
+
+    /**
+     * Save the tables once built.
+     */
+    void storeTables() { cache->store(); }
+
+    /**
+     * Storage for the model specific tables.
+     */
+    unsigned char* getExtraTables();
 
     virtual double getVoiceDC(unsigned int env) const = 0;
 
+    /**
+     * Build the op-amp tables common to both models, plus the model
+     * specific jobs, on a pool of threads sized to the machine.
+     *
+     * Each sub-table is an independent job with its own op-amp solver,
+     * and the dither only depends on the table position,
+     * so the result does not depend on the number of threads.
+     *
+     * @param opamp_voltage opamp voltage array
+     * @param opamp_size opamp voltage array size
+     * @param nRatio mixer input "resistor" ratio
+     * @param nDivisor volume "resistor" ladder divisor
+     * @param resonance_n the resonance gains
+     * @param extraJobs jobs building the model specific tables
+     */
+    void buildTables(
+        const Spline::Point *opamp_voltage,
+        int opamp_size,
+        double nRatio,
+        double nDivisor,
+        const double resonance_n[16],
+        std::vector<std::function<void()>> extraJobs);
+
     /**
      * The filter summer operates at n ~ 1, and has 5 fundamentally different
      * input configurations (2 - 6 input "resistors").
@@ -177,25 +253,24 @@ protected:
      * entirely accurate, since the input for each transistor is different,
      * and transistors are not linear components. However modeling all
      * transistors separately would be extremely costly.
+     *
+     * @param i the sub-table for 2 + i inputs
      */
-    inline void buildSummerTable(const OpAmp& opampModel)
+    inline void buildSummerTable(const OpAmp& opampModel, int i)
     {
         const double r_N16 = 1. / N16;
 
-        int idx = 0;
-        for (int i = 0; i < 5; i++)
+        const int idiv = 2 + i;        // 2 - 6 input "resistors".
+        const int size = idiv << 16;
+        const double n = idiv;
+        const double r_idiv = 1. / idiv;
+        opampModel.reset();
+
+        int idx = ((i * (i + 3)) / 2) << 16;
+        for (int vi = 0; vi < size; vi++, idx++)
         {
-            const int idiv = 2 + i;        // 2 - 6 input "resistors".
-            const int size = idiv << 16;
-            const double n = idiv;
-            const double r_idiv = 1. / idiv;
-            opampModel.reset();
-
-            for (int vi = 0; vi < size; vi++)
-            {
-                const double vin = vmin + vi * r_N16 * r_idiv; /* vmin .. vmax */
-                summer[idx++] = getNormalizedValue(opampModel.solve(n, vin));
-            }
+            const double vin = vmin + vi * r_N16 * r_idiv; /* vmin .. vmax */
+            summer[idx] = getNormalizedValue(opampModel.solve(n, vin), idx);
         }
     }
 
@@ -206,25 +281,24 @@ protected:
      *
      * All "on", transistors are modeled as one - see comments above for
      * the filter summer.
+     *
+     * @param i the sub-table for i inputs
      */
-    inline void buildMixerTable(const OpAmp& opampModel, double nRatio)
+    inline void buildMixerTable(const OpAmp& opampModel, double nRatio, int i)
     {
         const double r_N16 = 1. / N16;
 
-        int idx = 0;
-        for (int i = 0; i < 8; i++)
+        const int idiv = (i == 0) ? 1 : i;
+        const int size = (i == 0) ? 1 : i << 16;
+        const double n = i * nRatio;
+        const double r_idiv = 1. / idiv;
+        opampModel.reset();
+
+        int idx = (i == 0) ? 0 : 1 + (((i * (i - 1)) / 2) << 16);
+        for (int vi = 0; vi < size; vi++, idx++)
         {
-            const int idiv = (i == 0) ? 1 : i;
-            const int size = (i == 0) ? 1 : i << 16;
-            const double n = i * nRatio;
-            const double r_idiv = 1. / idiv;
-            opampModel.reset();
-
-            for (int vi = 0; vi < size; vi++)
-            {
-                const double vin = vmin + vi * r_N16 * r_idiv; /* vmin .. vmax */
-                mixer[idx++] = getNormalizedValue(opampModel.solve(n, vin));
-            }
+            const double vin = vmin + vi * r_N16 * r_idiv; /* vmin .. vmax */
+            mixer[idx] = getNormalizedValue(opampModel.solve(n, vin), idx);
         }
     }
 
@@ -234,23 +308,22 @@ protected:
      * From die photographs of the volume "resistor" ladders
      * it follows that gain ~ vol/12 (6581) or vol/16 (8580)
      * (assuming ideal op-amps and ideal "resistors").
+     *
+     * @param n8 the volume setting
      */
-    inline void buildVolumeTable(const OpAmp& opampModel, double nDivisor)
+    inline void buildVolumeTable(const OpAmp& opampModel, double nDivisor, int n8)
     {
         const double r_N16 = 1. / N16;
 
-        int idx = 0;
-        for (int n8 = 0; n8 < 16; n8++)
+        constexpr int size = 1 << 16;
+        const double n = n8 / nDivisor;
+        opampModel.reset();
+
+        int idx = n8 << 16;
+        for (int vi = 0; vi < size; vi++, idx++)
         {
-            constexpr int size = 1 << 16;
-            const double n = n8 / nDivisor;
-            opampModel.reset();
-
-            for (int vi = 0; vi < size; vi++)
-            {
-                const double vin = vmin + vi * r_N16; /* vmin .. vmax */
-                volume[idx++] = getNormalizedValue(opampModel.solve(n, vin));
-            }
+            const double vin = vmin + vi * r_N16; /* vmin .. vmax */
+            volume[idx] = getNormalizedValue(opampModel.solve(n, vin), idx);
         }
     }
 
@@ -260,40 +333,63 @@ protected:
      * From die photographs of the bandpass "resistor" ladders
      * it follows that 1/Q ~ ~res/8 (6581) or 2^((4 - res)/8) (8580)
      * (assuming ideal op-amps and ideal "resistors").
+     *
+     * @param n8 the resonance setting
      */
-    inline void buildResonanceTable(const OpAmp& opampModel, const double resonance_n[16])
+    inline void buildResonanceTable(const OpAmp& opampModel, double resonance_n, int n8)
     {
         const double r_N16 = 1. / N16;
 
-        int idx = 0;
-        for (int n8 = 0; n8 < 16; n8++)
+        constexpr int size = 1 << 16;
+        opampModel.reset();
+
+        int idx = n8 << 16;
+        for (int vi = 0; vi < size; vi++, idx++)
         {
-            constexpr int size = 1 << 16;
-            opampModel.reset();
-
-            for (int vi = 0; vi < size; vi++)
-            {
-                const double vin = vmin + vi * r_N16; /* vmin .. vmax */
-                resonance[idx++] = getNormalizedValue(opampModel.solve(resonance_n[n8], vin));
-            }
+            const double vin = vmin + vi * r_N16; /* vmin .. vmax */
+            resonance[idx] = getNormalizedValue(opampModel.solve(resonance_n, vin), idx);
         }
     }
 
 public:
-    unsigned short* getVolume() { return volume; }
-    unsigned short* getResonance() { return resonance; }
-    unsigned short* getSummer() { return summer; }
-    unsigned short* getMixer() { return mixer; }
+    /**
+     * Set the directory where the lookup tables are cached.
+     * Only models built afterwards are affected.
+     *
+     * @param dir the directory, empty to disable caching
+     */
+    static void setCacheDirectory(const char* dir) { FilterTableCache::setDirectory(dir); }
+
+    /**
+     * Get the storage of all the lookup tables, for the table generator.
+     */
+    const FilterTableCache& getTables() const { return *cache; }
+
+    /**
+     * Get the compact tables, building them on first use.
+     */
+    const CompactTables& getCompactTables();
+
+    const unsigned short* getVolume() const { return volume; }
+    const unsigned short* getResonance() const { return resonance; }
+    const unsigned short* getSummer() const { return summer; }
+    const unsigned short* getMixer() const { return mixer; }
 
     inline unsigned short getOpampRev(int i) const { return opamp_rev[i]; }
     inline double getVddt() const { return Vddt; }
     inline double getVth() const { return Vth; }
+    inline double getUCox() const { return uCox; }
 
     // helper functions
 
-    inline unsigned short getNormalizedValue(double value) const
+    /**
+     * Normalize a voltage, with the dither picked by position.
+     * The configuration is shared, so the dither sequence is kept
+     * by the caller, e.g. per table entry or per filter instance.
+     */
+    inline unsigned short getNormalizedValue(double value, unsigned int pos) const
     {
-        return to_ushort_dither(N16 * (value - vmin), rnd.getNoise());
+        return to_ushort_dither(N16 * (value - vmin), rnd.getNoise(pos));
     }
 
     template<int N>
@@ -302,14 +398,24 @@ public:
         return to_ushort((1 << N) * currFactorCoeff * wl);
     }
 
+    /**
+     * Same as above, for a transconductance coefficient
+     * other than the default one.
+     */
+    template<int N>
+    inline unsigned short getNormalizedCurrentFactor(double wl, double uCox) const
+    {
+        return to_ushort((1 << N) * (denorm * (uCox / 2. * 1.0e-6 / C)) * wl);
+    }
+
     inline unsigned short getNVmin() const
     {
         return to_ushort(N16 * vmin);
     }
 
-    inline int getNormalizedVoice(float value, unsigned int env) const
+    inline int getNormalizedVoice(float value, unsigned int env, unsigned int pos) const
     {
-        return static_cast<int>(getNormalizedValue(getVoiceVoltage(value, env)));
+        return static_cast<int>(getNormalizedValue(getVoiceVoltage(value, env), pos));
     }
 };
 
@@ -29,7 +29,6 @@
 
 #include <algorithm>
 #include <mutex>
-#include <thread>
 #include <cmath>
 #include <cstdint>
 
@@ -97,23 +96,16 @@ FilterModelConfig6581* FilterModelConfig6581::getInstance()
     return instance.get();
 }
 
-void FilterModelConfig6581::setFilterRange(double adjustment)
+double FilterModelConfig6581::getUCox(double adjustment)
 {
     // clamp into allowed range
 #ifdef HAVE_CXX17
-     adjustment = std::clamp(adjustment, 0.0, 1.0);
+    adjustment = std::clamp(adjustment, 0.0, 1.0);
 #else
-     adjustment = std::max(std::min(adjustment, 1.0), 0.);
+    adjustment = std::max(std::min(adjustment, 1.0), 0.);
 #endif
 
-     // Get the new uCox value, in the range [1,40]
-     const double new_uCox = (1. + 39. * adjustment) * 1e-6;
-
-    // Ignore small changes
-    if (std::abs(uCox - new_uCox) < 1e-12)
-        return;
-
-    setUCox(new_uCox);
+    return (1. + 39. * adjustment) * 1e-6;
 }
 
 FilterModelConfig6581::FilterModelConfig6581() :
@@ -124,7 +116,9 @@ FilterModelConfig6581::FilterModelConfig6581() :
         1.31,                   // Vth
         20e-6,                  // uCox
         opamp_voltage,
-        OPAMP_SIZE
+        OPAMP_SIZE,
+        "6581",
+        sizeof(unsigned short) * (1 << 16) + sizeof(double) * (1 << 16)
     ),
     WL_vcr(9.0 / 1.0),
     WL_snake(1.0 / 115.0),
@@ -134,6 +128,11 @@ FilterModelConfig6581::FilterModelConfig6581() :
 {
     dac.kinkedDac(MOS6581);
 
+    for (unsigned int i = 0; i < (1 << DAC_BITS); i++)
+    {
+        dacOutput.push_back(dac.getOutput(i) * dac_scale);
+    }
+
     {
         Dac envDac(8);
         envDac.kinkedDac(MOS6581);
@@ -144,69 +143,13 @@ FilterModelConfig6581::FilterModelConfig6581() :
         }
     }
 
-    // Create lookup tables for gains / summers.
+    vcr_nVg = reinterpret_cast<unsigned short*>(getExtraTables());
+    vcr_n_Ids_term = reinterpret_cast<double*>(getExtraTables() + sizeof(unsigned short) * (1 << 16));
 
-    //
-    // We spawn six threads to calculate these tables in parallel
-    //
-    auto filterSummer = [this]
-    {
-        OpAmp opampModel(
-            std::vector<Spline::Point>(
-                std::begin(opamp_voltage),
-                std::end(opamp_voltage)),
-            Vddt,
-            vmin,
-            vmax);
-
-        buildSummerTable(opampModel);
-    };
-
-    auto filterMixer = [this]
-    {
-        OpAmp opampModel(
-            std::vector<Spline::Point>(
-                std::begin(opamp_voltage),
-                std::end(opamp_voltage)),
-            Vddt,
-            vmin,
-            vmax);
-
-        buildMixerTable(opampModel, 8.0 / 6.0);
-    };
-
-    auto filterGain = [this]
-    {
-        OpAmp opampModel(
-            std::vector<Spline::Point>(
-                std::begin(opamp_voltage),
-                std::end(opamp_voltage)),
-            Vddt,
-            vmin,
-            vmax);
-
-        buildVolumeTable(opampModel, 12.0);
-    };
-
-    auto filterResonance = [this]
-    {
-        OpAmp opampModel(
-            std::vector<Spline::Point>(
-                std::begin(opamp_voltage),
-                std::end(opamp_voltage)),
-            Vddt,
-            vmin,
-            vmax);
-
-        // build temp n table
-        double resonance_n[16];
-        for (int n8 = 0; n8 < 16; n8++)
-        {
-            resonance_n[n8] = (~n8 & 0xf) / 8.0;
-        }
+    if (tablesCached())
+        return;
 
-        buildResonanceTable(opampModel, resonance_n);
-    };
+    // Create lookup tables for gains / summers.
 
     auto filterVcrVg = [this]
     {
@@ -249,42 +192,46 @@ FilterModelConfig6581::FilterModelConfig6581() :
         }
     };
 
-#if defined(HAVE_CXX20) && defined(__cpp_lib_jthread)
-    using sidThread = std::jthread;
-#else
-    using sidThread = std::thread;
-#endif
+    double resonance_n[16];
+    for (int n8 = 0; n8 < 16; n8++)
+    {
+        resonance_n[n8] = (~n8 & 0xf) / 8.0;
+    }
 
-    sidThread thdSummer(filterSummer);
-    sidThread thdMixer(filterMixer);
-    sidThread thdGain(filterGain);
-    sidThread thdResonance(filterResonance);
-    sidThread thdVcrVg(filterVcrVg);
-    sidThread thdVcrIds(filterVcrIds);
-
-#if !defined(HAVE_CXX20) || !defined(__cpp_lib_jthread)
-    thdSummer.join();
-    thdMixer.join();
-    thdGain.join();
-    thdResonance.join();
-    thdVcrVg.join();
-    thdVcrIds.join();
-#endif
+    buildTables(opamp_voltage, OPAMP_SIZE, 8.0 / 6.0, 12.0, resonance_n, { filterVcrVg, filterVcrIds });
+
+    storeTables();
 }
 
-unsigned short* FilterModelConfig6581::getDAC(double adjustment) const
+FilterModelConfig6581::DacTable FilterModelConfig6581::getDAC(int position)
 {
-    const double dac_zero = getDacZero(adjustment);
+    std::lock_guard<std::mutex> lock(dacLock);
 
-    unsigned short* f0_dac = new unsigned short[1 << DAC_BITS];
+    for (auto it = dacCache.begin(); it != dacCache.end(); ++it)
+    {
+        if (it->first == position)
+        {
+            dacCache.splice(dacCache.begin(), dacCache, it);
+            return it->second;
+        }
+    }
+
+    const double dac_zero = getDacZero(static_cast<double>(position) / CURVE_STEPS);
+
+    std::vector<unsigned short> f0_dac(1 << DAC_BITS);
 
     for (unsigned int i = 0; i < (1 << DAC_BITS); i++)
     {
-        const double fcd = dac.getOutput(i);
-        f0_dac[i] = getNormalizedValue(dac_zero + fcd * dac_scale);
+        f0_dac[i] = getNormalizedValue(dac_zero + dacOutput[i], i);
     }
 
-    return f0_dac;
+    DacTable table = std::make_shared<const std::vector<unsigned short>>(std::move(f0_dac));
+
+    dacCache.emplace_front(position, table);
+    if (dacCache.size() > DAC_CACHE_SIZE)
+        dacCache.pop_back();
+
+    return table;
 }
 
 } // namespace reSIDfp
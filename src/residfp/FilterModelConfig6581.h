@@ -25,7 +25,11 @@
 
 #include "FilterModelConfig.h"
 
+#include <list>
 #include <memory>
+#include <mutex>
+#include <utility>
+#include <vector>
 
 #include "Dac.h"
 
@@ -41,6 +45,17 @@ class Integrator6581;
  */
 class FilterModelConfig6581 final : public FilterModelConfig
 {
+public:
+    /// 11 bit cutoff frequency DAC output voltage table.
+    using DacTable = std::shared_ptr<const std::vector<unsigned short>>;
+
+    /// Number of steps the filter curve range is quantized to.
+    static constexpr int CURVE_STEPS = 256;
+
+private:
+    /// Maximum number of DAC tables kept in the cache.
+    static constexpr std::size_t DAC_CACHE_SIZE = 64;
+
 private:
     static std::unique_ptr<FilterModelConfig6581> instance;
     // This allows access to the private constructor
@@ -69,15 +84,24 @@ private:
     /// DAC lookup table
     Dac dac;
 
-    /// Voltage Controlled Resistors
+    /// Scaled DAC output voltages, independent of the curve position
+    std::vector<double> dacOutput;
+
+    /// Voltage Controlled Resistors, 1 << 16 entries each
     //@{
-    unsigned short vcr_nVg[1 << 16];
-    double vcr_n_Ids_term[1 << 16];
+    unsigned short* vcr_nVg;
+    double* vcr_n_Ids_term;
     //@}
 
     // Voice DC offset LUT
     double voiceDC[256];
 
+    /// DAC tables by quantized curve position, most recently used first.
+    //@{
+    std::mutex dacLock;
+    std::list<std::pair<int, DacTable>> dacCache;
+    //@}
+
 private:
     double getDacZero(double adjustment) const { return dac_zero + (1. - adjustment); }
 
@@ -97,22 +121,31 @@ protected:
 public:
     static FilterModelConfig6581* getInstance();
 
-    void setFilterRange(double adjustment);
+    /**
+     * Get the transconductance coefficient for a filter range.
+     *
+     * @param adjustment 0 .. 1, clamped
+     * @return u*Cox, in the range [1,40]e-6
+     */
+    static double getUCox(double adjustment);
+
+    using FilterModelConfig::getUCox;
 
     /**
-     * Construct an 11 bit cutoff frequency DAC output voltage table.
-     * Ownership is transferred to the requester which becomes responsible
-     * of freeing the object when done.
+     * Get the 11 bit cutoff frequency DAC output voltage table
+     * for a quantized curve position.
+     * The tables are built on demand and kept in a small LRU cache,
+     * the returned table stays valid as long as it is referenced.
      *
-     * @param adjustment
+     * @param position curve position, 0 .. #CURVE_STEPS
      * @return the DAC table
      */
-    unsigned short* getDAC(double adjustment) const;
+    DacTable getDAC(int position);
 
     inline double getWL_snake() const { return WL_snake; }
 
     inline unsigned short getVcr_nVg(int i) const { return vcr_nVg[i]; }
-    inline unsigned short getVcr_n_Ids_term(int i) const
+    inline unsigned short getVcr_n_Ids_term(int i, double uCox) const
     {
         return to_ushort(vcr_n_Ids_term[i] * uCox);
     }
@@ -28,7 +28,6 @@
 #include "sidcxx11.h"
 
 #include <mutex>
-#include <thread>
 
 namespace reSIDfp
 {
@@ -112,6 +111,14 @@ constexpr Spline::Point opamp_voltage[OPAMP_SIZE] =
     {  8.91,  1.30 },  // Approximate end of actual range
 };
 
+/**
+ * W/L ratio of frequency DAC bit 0,
+ * other bit are proportional.
+ * When no bit are selected a resistance with half
+ * W/L ratio is selected.
+ */
+constexpr double DAC_WL0 = 0.00615;
+
 std::unique_ptr<FilterModelConfig8580> FilterModelConfig8580::instance(nullptr);
 
 std::mutex Instance8580_Lock;
@@ -136,83 +143,42 @@ FilterModelConfig8580::FilterModelConfig8580() :
         0.80,               // Vth
         100e-6,             // uCox
         opamp_voltage,
-        OPAMP_SIZE
+        OPAMP_SIZE,
+        "8580",
+        0
     )
 {
+    for (unsigned int fc = 0; fc < (1 << DAC_BITS); fc++)
+    {
+        double wl;
+        double dacWL = DAC_WL0;
+        if (fc)
+        {
+            wl = 0.;
+            for (unsigned int i = 0; i < DAC_BITS; i++)
+            {
+                if (fc & (1 << i))
+                {
+                    wl += dacWL;
+                }
+                dacWL *= 2.;
+            }
+        }
+        else
+        {
+            wl = dacWL/2.;
+        }
+
+        n_dac[fc] = getNormalizedCurrentFactor<17>(wl);
+    }
+
+    if (tablesCached())
+        return;
+
     // Create lookup tables for gains / summers.
+    buildTables(opamp_voltage, OPAMP_SIZE, 8.0 / 5.0, 16.0, resGain, {});
 
-    //
-    // We spawn four threads to calculate these tables in parallel
-    //
-    auto filterSummer = [this]
-    {
-        OpAmp opampModel(
-            std::vector<Spline::Point>(
-                std::begin(opamp_voltage),
-                std::end(opamp_voltage)),
-            Vddt,
-            vmin,
-            vmax);
-
-        buildSummerTable(opampModel);
-    };
-
-    auto filterMixer = [this]
-    {
-        OpAmp opampModel(
-            std::vector<Spline::Point>(
-                std::begin(opamp_voltage),
-                std::end(opamp_voltage)),
-            Vddt,
-            vmin,
-            vmax);
-
-        buildMixerTable(opampModel, 8.0 / 5.0);
-    };
-
-    auto filterGain = [this]
-    {
-        OpAmp opampModel(
-            std::vector<Spline::Point>(
-                std::begin(opamp_voltage),
-                std::end(opamp_voltage)),
-            Vddt,
-            vmin,
-            vmax);
-
-        buildVolumeTable(opampModel, 16.0);
-    };
-
-    auto filterResonance = [this]
-    {
-        OpAmp opampModel(
-            std::vector<Spline::Point>(
-                std::begin(opamp_voltage),
-                std::end(opamp_voltage)),
-            Vddt,
-            vmin,
-            vmax);
-
-        buildResonanceTable(opampModel, resGain);
-    };
-
-#if defined(HAVE_CXX20) && defined(__cpp_lib_jthread)
-    using sidThread = std::jthread;
-#else
-    using sidThread = std::thread;
-#endif
-
-    sidThread thdSummer(filterSummer);
-    sidThread thdMixer(filterMixer);
-    sidThread thdGain(filterGain);
-    sidThread thdResonance(filterResonance);
-
-#if !defined(HAVE_CXX20) || !defined(__cpp_lib_jthread)
-    thdSummer.join();
-    thdMixer.join();
-    thdGain.join();
-    thdResonance.join();
-#endif
+    storeTables();
 }
 
 } // namespace reSIDfp
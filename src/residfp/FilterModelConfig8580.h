@@ -55,6 +55,12 @@ private:
      */
     static constexpr double VOLTAGE_SKEW = 1.01;
 
+    static constexpr unsigned int DAC_BITS = 11;
+
+private:
+    /// Normalized current factor of the cutoff frequency DAC, by FC register value.
+    unsigned short n_dac[1 << DAC_BITS];
+
 private:
     FilterModelConfig8580();
     ~FilterModelConfig8580() = default;
@@ -66,6 +72,14 @@ public:
     static FilterModelConfig8580* getInstance();
 
     static inline constexpr double getVref() { return Vref * VOLTAGE_SKEW; }
+
+    /**
+     * Get the normalized current factor of the cutoff frequency DAC,
+     * 1 cycle at 1MHz.
+     *
+     * @param fc the 11 bit cutoff frequency register value
+     */
+    inline unsigned short getDacCurrentFactor(unsigned int fc) const { return n_dac[fc]; }
 };
 
 } // namespace reSIDfp
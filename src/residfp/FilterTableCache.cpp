@@ -0,0 +1,260 @@
+/*
+ * This file is part of libsidplayfp, a SID player engine.
+ *
+ * Copyright 2011-2024 Leandro Nini <drfiemost@users.sourceforge.net>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+#include "FilterTableCache.h"
+
+#include "siddefs-fp.h"
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <mutex>
+
+#ifdef HAVE_SYS_MMAN_H
+#  include <fcntl.h>
+#  include <sys/mman.h>
+#  include <sys/stat.h>
+#  include <unistd.h>
+#endif
+
+namespace reSIDfp
+{
+
+namespace
+{
+
+/// Cache file header, followed by the table data
+struct Header
+{
+    char magic[8];
+    std::uint32_t version;
+    std::uint32_t byteOrder;    ///< Detects files written on a machine with different endianness
+    std::uint64_t key;
+    std::uint64_t size;
+    std::uint64_t checksum;
+};
+
+constexpr char MAGIC[8] = { 'R', 'E', 'S', 'I', 'D', 'F', 'P', 'T' };
+
+constexpr std::uint32_t BYTE_ORDER_MARK = 0x01020304;
+
+std::mutex CacheDir_Lock;
+
+/// Number of the next temporary file of this process
+std::atomic<unsigned int> tmpCounter(0);
+
+std::string cacheDir;
+
+}
+
+void FilterTableCache::setDirectory(const char* dir)
+{
+    std::lock_guard<std::mutex> lock(CacheDir_Lock);
+    cacheDir = dir;
+}
+
+std::uint64_t FilterTableCache::hash(const void* buf, std::size_t len, std::uint64_t hash)
+{
+    const unsigned char* p = static_cast<const unsigned char*>(buf);
+
+    for (std::size_t i = 0; i < len; i++)
+    {
+        hash ^= p[i];
+        hash *= 0x100000001b3ull;
+    }
+
+    return hash;
+}
+
+std::uint64_t FilterTableCache::checksum(const unsigned char* tables, std::size_t len)
+{
+    // FNV-1a over 64 bit words, the table size is a multiple of 8
+    std::uint64_t hash = 0xcbf29ce484222325ull;
+
+    for (std::size_t i = 0; i < len; i += 8)
+    {
+        std::uint64_t word;
+        std::memcpy(&word, tables + i, sizeof(word));
+        hash ^= word;
+        hash *= 0x100000001b3ull;
+    }
+
+    return hash;
+}
+
+FilterTableCache::FilterTableCache(const char* name, std::uint64_t key, std::size_t size) :
+    size((size + 7) & ~static_cast<std::size_t>(7)),
+    key(hash(residfp_version_string, std::strlen(residfp_version_string), key))
+{
+#ifdef EMBEDDED_FILTER_TABLES
+    for (const Embedded* e = embedded; e->name != nullptr; e++)
+    {
+        if ((std::strcmp(e->name, name) == 0) && (e->key == this->key) && (e->size == this->size))
+        {
+            // Read-only data, never written since loaded is set
+            data = const_cast<unsigned char*>(e->data);
+            loaded = true;
+            return;
+        }
+    }
+#endif
+
+    {
+        std::lock_guard<std::mutex> lock(CacheDir_Lock);
+
+        if (!cacheDir.empty())
+        {
+            char file[64];
+            std::snprintf(file, sizeof(file), "/residfp-%s-%016llx.tables",
+                name, static_cast<unsigned long long>(this->key));
+            path = cacheDir + file;
+        }
+    }
+
+    loaded = !path.empty() && load();
+
+    if (!loaded)
+    {
+        data = new unsigned char[this->size]();
+        owned = true;
+    }
+}
+
+FilterTableCache::~FilterTableCache()
+{
+#ifdef HAVE_SYS_MMAN_H
+    if (mapping != nullptr)
+    {
+        munmap(mapping, mappingSize);
+    }
+#endif
+
+    if (owned)
+    {
+        delete [] data;
+    }
+}
+
+bool FilterTableCache::validate(const void* header, const unsigned char* tables) const
+{
+    Header h;
+    std::memcpy(&h, header, sizeof(h));
+
+    return (std::memcmp(h.magic, MAGIC, sizeof(MAGIC)) == 0)
+        && (h.version == VERSION)
+        && (h.byteOrder == BYTE_ORDER_MARK)
+        && (h.key == key)
+        && (h.size == size)
+        && (h.checksum == checksum(tables, size));
+}
+
+bool FilterTableCache::load()
+{
+    const std::size_t fileSize = sizeof(Header) + size;
+
+#ifdef HAVE_SYS_MMAN_H
+    const int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0)
+        return false;
+
+    struct stat st;
+    void* p = MAP_FAILED;
+    if ((fstat(fd, &st) == 0) && (static_cast<std::size_t>(st.st_size) == fileSize))
+    {
+        p = mmap(nullptr, fileSize, PROT_READ, MAP_SHARED, fd, 0);
+    }
+    close(fd);
+
+    if (p == MAP_FAILED)
+        return false;
+
+    unsigned char* tables = static_cast<unsigned char*>(p) + sizeof(Header);
+
+    if (!validate(p, tables))
+    {
+        munmap(p, fileSize);
+        return false;
+    }
+
+    mapping = p;
+    mappingSize = fileSize;
+    data = tables;
+    return true;
+#else
+    std::FILE* f = std::fopen(path.c_str(), "rb");
+    if (f == nullptr)
+        return false;
+
+    Header h;
+    unsigned char* tables = new unsigned char[size];
+    const bool ok = (std::fread(&h, sizeof(h), 1, f) == 1)
+        && (std::fread(tables, 1, size, f) == size)
+        && (std::fgetc(f) == EOF);
+    std::fclose(f);
+
+    if (!ok || !validate(&h, tables))
+    {
+        delete [] tables;
+        return false;
+    }
+
+    data = tables;
+    owned = true;
+    return true;
+#endif
+}
+
+void FilterTableCache::store() const
+{
+    if (path.empty() || loaded)
+        return;
+
+    Header h;
+    std::memcpy(h.magic, MAGIC, sizeof(MAGIC));
+    h.version = VERSION;
+    h.byteOrder = BYTE_ORDER_MARK;
+    h.key = key;
+    h.size = size;
+    h.checksum = checksum(data, size);
+
+    // Unique temporary name, so that concurrent writers don't collide
+#ifdef HAVE_SYS_MMAN_H
+    const unsigned long long process = static_cast<unsigned long long>(getpid());
+#else
+    const unsigned long long process = static_cast<unsigned long long>(
+        std::chrono::steady_clock::now().time_since_epoch().count());
+#endif
+    const std::string tmp = path + "." + std::to_string(process) + "-" + std::to_string(tmpCounter++) + ".tmp";
+
+    std::FILE* f = std::fopen(tmp.c_str(), "wb");
+    if (f == nullptr)
+        return;
+
+    const bool ok = (std::fwrite(&h, sizeof(h), 1, f) == 1)
+        && (std::fwrite(data, 1, size, f) == size);
+
+    if ((std::fclose(f) != 0) || !ok || (std::rename(tmp.c_str(), path.c_str()) != 0))
+    {
+        std::remove(tmp.c_str());
+    }
+}
+
+} // namespace reSIDfp
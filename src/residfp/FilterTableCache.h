@@ -0,0 +1,152 @@
+/*
+ * This file is part of libsidplayfp, a SID player engine.
+ *
+ * Copyright 2011-2024 Leandro Nini <drfiemost@users.sourceforge.net>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+#ifndef FILTERTABLECACHE_H
+#define FILTERTABLECACHE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+#include "sidcxx11.h"
+
+namespace reSIDfp
+{
+
+/**
+ * Contiguous storage for the filter model lookup tables,
+ * optionally persisted to an on-disk cache.
+ *
+ * When a cache directory is set, the tables are looked up in a file
+ * named after the model and a key hashed from the model parameters.
+ * A valid file is mapped read-only, so that all processes on a host
+ * share the same physical pages. Otherwise zeroed storage is allocated
+ * and the caller is expected to build the tables and #store them.
+ *
+ * When built with EMBEDDED_FILTER_TABLES, tables generated at build time
+ * are linked into the binary and take precedence over the file cache.
+ *
+ * Cache failures are never fatal, the tables are just built again.
+ */
+class FilterTableCache
+{
+public:
+    /// Tables generated at build time
+    struct Embedded
+    {
+        const char* name;
+        std::uint64_t key;
+        std::size_t size;
+        const unsigned char* data;
+    };
+
+private:
+    /// Bump when the table layout or the table generation code changes
+    static constexpr std::uint32_t VERSION = 2;
+
+private:
+    /// Table data
+    unsigned char* data = nullptr;
+
+    /// Size of the table data in bytes
+    std::size_t size;
+
+    /// Start and size of the mapped file, if the data was loaded with mmap
+    //@{
+    void* mapping = nullptr;
+    std::size_t mappingSize = 0;
+    //@}
+
+    /// Hash of the model parameters
+    const std::uint64_t key;
+
+    /// Cache file, empty if caching is disabled
+    std::string path;
+
+    /// Whether the data was loaded from the cache
+    bool loaded = false;
+
+    /// Whether the data was allocated on the heap
+    bool owned = false;
+
+private:
+    FilterTableCache(const FilterTableCache&) = delete;
+    FilterTableCache& operator= (const FilterTableCache&) = delete;
+
+    bool load();
+
+    bool validate(const void* header, const unsigned char* tables) const;
+
+    static std::uint64_t checksum(const unsigned char* tables, std::size_t len);
+
+    /// The embedded tables, terminated by an entry with null name
+    static const Embedded embedded[];
+
+public:
+    /**
+     * Set the directory for the cache files.
+     * Affects the models which are built afterwards.
+     *
+     * @param dir the directory, empty to disable caching
+     */
+    static void setDirectory(const char* dir);
+
+    /**
+     * Compute a 64 bit FNV-1a hash, also used to build the cache keys.
+     *
+     * @param buf the data to hash
+     * @param len the data length in bytes
+     * @param hash the hash of the preceding data
+     */
+    static std::uint64_t hash(const void* buf, std::size_t len, std::uint64_t hash = 0xcbf29ce484222325ull);
+
+    /**
+     * @param name the model name
+     * @param key hash of the model parameters
+     * @param size size of the tables in bytes
+     */
+    FilterTableCache(const char* name, std::uint64_t key, std::size_t size);
+    ~FilterTableCache();
+
+    /**
+     * Check whether the tables were loaded from the cache.
+     * The data is read-only in that case.
+     */
+    bool isLoaded() const { return loaded; }
+
+    unsigned char* getData() { return data; }
+    const unsigned char* getData() const { return data; }
+
+    /// Size of the table data in bytes, a multiple of 8
+    std::size_t getSize() const { return size; }
+
+    std::uint64_t getKey() const { return key; }
+
+    /**
+     * Write the tables to the cache, if enabled.
+     * The file is written to a temporary name and renamed,
+     * so concurrent processes never see a partial file.
+     */
+    void store() const;
+};
+
+} // namespace reSIDfp
+
+#endif
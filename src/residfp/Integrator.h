@@ -39,6 +39,15 @@ protected:
 public:
     virtual int solve(int vi) const = 0;
 
+    /**
+     * Get the state, vx and vc.
+     */
+    void getState(int state[2]) const
+    {
+        state[0] = vx;
+        state[1] = vc;
+    }
+
     virtual ~Integrator() = default;
 };
 
@@ -30,24 +30,24 @@
 namespace reSIDfp
 {
 
-int Integrator6581::solve(int vi) const
+int Integrator6581::getCurrent(int vs, int vi) const
 {
     // Make sure Vgst>0 so we're not in subthreshold mode
-    assert(vx < nVddt);
+    assert(vs < nVddt);
 
     // Check that transistor is actually in triode mode
     // Vds < Vgs - Vth
     assert(vi < nVddt);
 
     // "Snake" voltages for triode mode calculation.
-    const unsigned int Vgst = nVddt - vx;
+    const unsigned int Vgst = nVddt - vs;
     const unsigned int Vgdt = nVddt - vi;
 
     const unsigned int Vgst_2 = Vgst * Vgst;
     const unsigned int Vgdt_2 = Vgdt * Vgdt;
 
     // "Snake" current, scaled by (1/m)*2^13*m*2^16*m*2^16*2^-15 = m*2^30
-    const int n_I_snake = fmc.getNormalizedCurrentFactor<13>(wlSnake) * (static_cast<int>(Vgst_2 - Vgdt_2) >> 15);
+    const int n_I_snake = n_snake * (static_cast<int>(Vgst_2 - Vgdt_2) >> 15);
 
     // VCR gate voltage.       // Scaled by m*2^16
     // Vg = Vddt - sqrt(((Vddt - Vw)^2 + Vgdt^2)/2)
@@ -60,14 +60,14 @@ int Integrator6581::solve(int vi) const
 #endif
 
     // VCR voltages for EKV model table lookup.
-    const int kVgt_Vs = (kVgt - vx) - INT16_MIN;
+    const int kVgt_Vs = (kVgt - vs) - INT16_MIN;
     assert((kVgt_Vs >= 0) && (kVgt_Vs <= UINT16_MAX));
     const int kVgt_Vd = (kVgt - vi) - INT16_MIN;
     assert((kVgt_Vd >= 0) && (kVgt_Vd <= UINT16_MAX));
 
     // VCR current, scaled by m*2^15*2^15 = m*2^30
-    const unsigned int If = static_cast<unsigned int>(fmc.getVcr_n_Ids_term(kVgt_Vs)) << 15;
-    const unsigned int Ir = static_cast<unsigned int>(fmc.getVcr_n_Ids_term(kVgt_Vd)) << 15;
+    const unsigned int If = static_cast<unsigned int>(fmc.getVcr_n_Ids_term(kVgt_Vs, uCox)) << 15;
+    const unsigned int Ir = static_cast<unsigned int>(fmc.getVcr_n_Ids_term(kVgt_Vd, uCox)) << 15;
 #ifdef SLOPE_FACTOR
     const double iVcr = static_cast<double>(If - Ir);
     const int n_I_vcr = static_cast<int>(iVcr * n);
@@ -84,8 +84,13 @@ int Integrator6581::solve(int vi) const
     assert((n > 1.2) && (n < 1.8));
 #endif
 
+    return n_I_snake + n_I_vcr;
+}
+
+int Integrator6581::solve(int vi) const
+{
     // Change in capacitor charge.
-    vc += n_I_snake + n_I_vcr;
+    vc += getCurrent(vx, vi);
 
     // vx = g(vc)
     const int tmp = (vc >> 15) - INT16_MIN;
@@ -96,4 +101,11 @@ int Integrator6581::solve(int vi) const
     return vx - (vc >> 14);
 }
 
+double Integrator6581::getLinearGain(int v0) const
+{
+    constexpr int dv = 1 << 8;
+    const int dI = getCurrent(v0, v0 + dv) - getCurrent(v0, v0 - dv);
+    return dI / (2. * dv);
+}
+
 } // namespace reSIDfp
@@ -166,6 +166,12 @@ class Integrator6581 : public Integrator
 private:
     const double wlSnake;
 
+    /// Transconductance coefficient, set by the filter range.
+    double uCox;
+
+    /// Normalized current factor of the snake, scaled by (1/m)*2^13.
+    int n_snake;
+
 #ifdef SLOPE_FACTOR
     // Slope factor n = 1/k
     // where k is the gate coupling coefficient
@@ -181,21 +187,55 @@ private:
 
     FilterModelConfig6581& fmc;
 
+private:
+    /**
+     * Current through the snake and the VCR, scaled by m*2^30.
+     *
+     * @param vs voltage at the op-amp input
+     * @param vi input voltage
+     */
+    inline int getCurrent(int vs, int vi) const;
+
 public:
     Integrator6581(FilterModelConfig6581& fmc) :
         wlSnake(fmc.getWL_snake()),
+        uCox(fmc.getUCox()),
+        n_snake(fmc.getNormalizedCurrentFactor<13>(wlSnake)),
 #ifdef SLOPE_FACTOR
         n(1.4),
 #endif
         nVddt_Vw_2(0),
-        nVddt(fmc.getNormalizedValue(fmc.getVddt())),
-        nVt(fmc.getNormalizedValue(fmc.getVth())),
+        nVddt(fmc.getNormalizedValue(fmc.getVddt(), 0)),
+        nVt(fmc.getNormalizedValue(fmc.getVth(), 0)),
         nVmin(fmc.getNVmin()),
         fmc(fmc) {}
 
     void setVw(unsigned short Vw) { nVddt_Vw_2 = ((nVddt - Vw) * (nVddt - Vw)) >> 1; }
 
+    /**
+     * Set the transconductance coefficient.
+     * Kept per integrator, as the lookup tables don't depend on it.
+     *
+     * @param new_uCox u*Cox
+     * @see FilterModelConfig6581::getUCox(double)
+     */
+    void setUCox(double new_uCox)
+    {
+        uCox = new_uCox;
+        n_snake = fmc.getNormalizedCurrentFactor<13>(wlSnake, uCox);
+    }
+
     int solve(int vi) const override;
+
+    /**
+     * Small signal transconductance around a working point,
+     * for the linearized integrator.
+     *
+     * @param v0 normalized op-amp working point
+     * @return change in capacitor charge per cycle per unit of input
+     * @see IntegratorLinear
+     */
+    double getLinearGain(int v0) const;
 };
 
 } // namespace reSIDfp
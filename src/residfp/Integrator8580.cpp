@@ -25,23 +25,26 @@
 namespace reSIDfp
 {
 
-int Integrator8580::solve(int vi) const
+int Integrator8580::getCurrent(int vs, int vi) const
 {
     // Make sure we're not in subthreshold mode
-    assert(vx < nVgt);
+    assert(vs < nVgt);
 
     // DAC voltages
-    const unsigned int Vgst = nVgt - vx;
+    const unsigned int Vgst = nVgt - vs;
     const unsigned int Vgdt = (vi < nVgt) ? nVgt - vi : 0;  // triode/saturation mode
 
     const unsigned int Vgst_2 = Vgst * Vgst;
     const unsigned int Vgdt_2 = Vgdt * Vgdt;
 
     // DAC current, scaled by (1/m)*2^13*m*2^16*m*2^16*2^-15 = m*2^30
-    const int n_I_dac = (n_dac * (static_cast<int>(Vgst_2 - Vgdt_2) >> 15)) >> 4;
+    return (n_dac * (static_cast<int>(Vgst_2 - Vgdt_2) >> 15)) >> 4;
+}
 
+int Integrator8580::solve(int vi) const
+{
     // Change in capacitor charge.
-    vc += n_I_dac;
+    vc += getCurrent(vx, vi);
 
     // vx = g(vc)
     const int tmp = (vc >> 15) - INT16_MIN;
@@ -52,4 +55,11 @@ int Integrator8580::solve(int vi) const
     return vx - (vc >> 14);
 }
 
+double Integrator8580::getLinearGain(int v0) const
+{
+    constexpr int dv = 1 << 8;
+    const int dI = getCurrent(v0, v0 + dv) - getCurrent(v0, v0 - dv);
+    return dI / (2. * dv);
+}
+
 } // namespace reSIDfp
@@ -60,6 +60,15 @@ private:
 
     FilterModelConfig8580& fmc;
 
+private:
+    /**
+     * DAC current, scaled by m*2^30.
+     *
+     * @param vs voltage at the op-amp input
+     * @param vi input voltage
+     */
+    inline int getCurrent(int vs, int vi) const;
+
 public:
     Integrator8580(FilterModelConfig8580& fmc) :
         fmc(fmc)
@@ -69,12 +78,11 @@ public:
 
     /**
      * Set Filter Cutoff resistor ratio.
+     *
+     * @param n_dac normalized current factor, 1 cycle at 1MHz
+     * @see FilterModelConfig8580::getDacCurrentFactor
      */
-    void setFc(double wl)
-    {
-        // Normalized current factor, 1 cycle at 1MHz.
-        n_dac = fmc.getNormalizedCurrentFactor<17>(wl);
-    }
+    void setFc(unsigned short n_dac) { this->n_dac = n_dac; }
 
     /**
      * Set FC gate voltage multiplier.
@@ -89,10 +97,20 @@ public:
 
         // Vg - Vth, normalized so that translated values can be subtracted:
         // Vgt - x = (Vgt - t) - (x - t)
-        nVgt = fmc.getNormalizedValue(Vgt);
+        nVgt = fmc.getNormalizedValue(Vgt, 0);
     }
 
     int solve(int vi) const override;
+
+    /**
+     * Small signal transconductance around a working point,
+     * for the linearized integrator.
+     *
+     * @param v0 normalized op-amp working point
+     * @return change in capacitor charge per cycle per unit of input
+     * @see IntegratorLinear
+     */
+    double getLinearGain(int v0) const;
 };
 
 } // namespace reSIDfp
@@ -0,0 +1,118 @@
+/*
+ * This file is part of libsidplayfp, a SID player engine.
+ *
+ * Copyright 2011-2024 Leandro Nini <drfiemost@users.sourceforge.net>
+ * Copyright 2007-2010 Antti Lankila
+ * Copyright 2004, 2010 Dag Lem <resid@nimrod.no>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+#ifndef INTEGRATORLINEAR_H
+#define INTEGRATORLINEAR_H
+
+#include "Integrator.h"
+#include "FilterModelConfig.h"
+
+#include <stdint.h>
+#include <algorithm>
+
+namespace reSIDfp
+{
+
+/**
+ * Linearized integrator for the faster quality levels.
+ *
+ * The capacitor is charged proportionally to the voltage across
+ * the input resistor, with the op-amp linearized around its
+ * working point v0:
+ *
+ *     vx = v0 + r*(v0 - vo)
+ *     vc = vc0 + g*(vi - vx)
+ *     vo = v0 - vc
+ *
+ * where r accounts for the finite op-amp gain and g is the small
+ * signal transconductance of the chip specific integrator.
+ */
+class IntegratorLinear : public Integrator
+{
+private:
+    /// Op-amp working point, normalized
+    const int v0;
+
+    /// Op-amp input voltage change per unit of output change, scaled by 2^16
+    const int feedback;
+
+    /// Output voltage change per unit of capacitor charge
+    const double chargeGain;
+
+    /// Capacitor voltage limits, so that vo stays within 16 bits
+    //@{
+    const int vcMin;
+    const int vcMax;
+    //@}
+
+    /// Change in capacitor voltage per cycle per unit of input, scaled by 2^20
+    int gain;
+
+private:
+    /**
+     * Slope of the op-amp input voltage with respect to the
+     * capacitor charge at the working point, scaled by 2^15.
+     */
+    static double getOpampSlope(const FilterModelConfig& fmc)
+    {
+        constexpr int di = 1 << 8;
+        return (fmc.getOpampRev((1 << 15) + di) - fmc.getOpampRev((1 << 15) - di)) / (2. * di);
+    }
+
+public:
+    IntegratorLinear(const FilterModelConfig& fmc) :
+        v0(fmc.getOpampRev(1 << 15)),
+        feedback(static_cast<int>(getOpampSlope(fmc) / (2. - getOpampSlope(fmc)) * (1 << 16) + 0.5)),
+        chargeGain((2. - getOpampSlope(fmc)) / (1 << 15)),
+        vcMin((v0 - 0xffff) * (1 << 12)),
+        vcMax(v0 * (1 << 12)),
+        gain(0) {}
+
+    /**
+     * Set the integrator transconductance.
+     *
+     * @param g change in capacitor charge per cycle per unit of input
+     */
+    void setGain(double g) { gain = static_cast<int>(g * chargeGain * (1 << 20) + 0.5); }
+
+    /**
+     * Get the op-amp working point.
+     */
+    int getWorkingPoint() const { return v0; }
+
+    int solve(int vi) const override
+    {
+        // Op-amp input, relative to the working point
+        const int dvx = (feedback * (vc >> 12)) >> 16;
+
+        // Capacitor voltage, scaled by 2^12
+        vc += static_cast<int>((static_cast<int64_t>(gain) * (vi - v0 - dvx)) >> 8);
+        vc = std::min(std::max(vc, vcMin), vcMax);
+
+        // Return vo.
+        return v0 - (vc >> 12);
+    }
+};
+
+} // namespace reSIDfp
+
+#endif
@@ -24,7 +24,11 @@
 
 #include "SID.h"
 
+#include <algorithm>
+#include <cmath>
+#include <iterator>
 #include <limits>
+#include <mutex>
 
 #include "sidcxx11.h"
 
@@ -33,7 +37,7 @@
 #include "Filter6581.h"
 #include "Filter8580.h"
 #include "WaveformCalculator.h"
-#include "resample/TwoPassSincResampler.h"
+#include "resample/CascadeResampler.h"
 #include "resample/ZeroOrderResampler.h"
 
 namespace reSIDfp
@@ -139,45 +143,227 @@ constexpr int BUS_TTL_6581 = 0x01d00;
 constexpr int BUS_TTL_8580 = 0xa2000;
 //@}
 
-SID::SID() :
-    filter6581(new Filter6581()),
-    filter8580(new Filter8580()),
+namespace
+{
+
+/**
+ * Emulated nonlinearity of the envelope and oscillator DACs.
+ * The tables only depend on the chip model, so they are
+ * built once and shared by all the instances.
+ *
+ * @See Dac
+ */
+struct DacTables
+{
+    float envDAC[1 << ENV_DAC_BITS];
+    float oscDAC[1 << OSC_DAC_BITS];
+
+    explicit DacTables(ChipModel model)
+    {
+        // calculate envelope DAC table
+        {
+            Dac dacBuilder(ENV_DAC_BITS);
+            dacBuilder.kinkedDac(model);
+
+            for (unsigned int i = 0; i < (1 << ENV_DAC_BITS); i++)
+            {
+                envDAC[i] = static_cast<float>(dacBuilder.getOutput(i));
+            }
+        }
+
+        // calculate oscillator DAC table
+        const bool is6581 = model == MOS6581;
+
+        {
+            Dac dacBuilder(OSC_DAC_BITS);
+            dacBuilder.kinkedDac(model);
+
+            //const double offset = dacBuilder.getOutput(is6581 ? OFFSET_6581 : OFFSET_8580);
+            const double offset = dacBuilder.getOutput(0x7ff, is6581);
+
+            for (unsigned int i = 0; i < (1 << OSC_DAC_BITS); i++)
+            {
+                const double dacValue = dacBuilder.getOutput(i, is6581);
+                oscDAC[i] = static_cast<float>(dacValue - offset);
+            }
+        }
+    }
+};
+
+const DacTables& getDacTables(ChipModel model)
+{
+    // Built on first use, initialization of local statics is thread safe
+    if (model == MOS6581)
+    {
+        static const DacTables dac6581(MOS6581);
+        return dac6581;
+    }
+
+    static const DacTables dac8580(MOS8580);
+    return dac8580;
+}
+
+/**
+ * Settings of a chip profile.
+ */
+struct ChipProfileConfig
+{
+    ChipModel model;
+    CombinedWaveforms cws;
+    double filterCurve;
+    double filterRange;     ///< 6581 only
+};
+
+/**
+ * Combined waveforms follow the chips sampled for WaveformCalculator:
+ * - 6581 R2: 4383 (weak, ltx128) and 0384 (strong, Trurl)
+ * - 6581 R3: 0486S (average, Trurl)
+ * - 8580 R5: 1088 (average), 4887 (weak) and 1489 (strong), all by reFX-Mike
+ * The 6581 R4AR has not been sampled and gets the average ones.
+ *
+ * The filter settings are approximations, not measurements:
+ * the R3 keeps the defaults, the R2 is set somewhat darker
+ * and the R4AR somewhat brighter, as those revisions are usually described.
+ * Individual chips vary a lot, so they are only a starting point.
+ */
+const ChipProfileConfig profileConfigs[] =
+{
+    { MOS6581, WEAK,    0.6, 0.4 },  // MOS6581R2
+    { MOS6581, STRONG,  0.6, 0.4 },  // MOS6581R2_STRONG
+    { MOS6581, AVERAGE, 0.5, 0.5 },  // MOS6581R3
+    { MOS6581, AVERAGE, 0.4, 0.6 },  // MOS6581R4AR
+    { MOS8580, AVERAGE, 0.5, 0. },   // MOS8580R5
+    { MOS8580, WEAK,    0.5, 0. },   // MOS8580R5_WEAK
+    { MOS8580, STRONG,  0.5, 0. },   // MOS8580R5_STRONG
+};
+
+constexpr int NUM_PROFILES = sizeof(profileConfigs) / sizeof(profileConfigs[0]);
+
+/**
+ * Waveform tables of a chip profile, looked up once
+ * and shared by all the instances.
+ * The filter tables are shared per chip model,
+ * the 6581 DAC tables are cached by curve position.
+ */
+struct ProfileTables
+{
+    const ChipProfileConfig* config = nullptr;
+    matrix_t* pulldown = nullptr;
+    matrix_t* fused = nullptr;
+};
+
+const ProfileTables& getProfileTables(ChipProfile profile)
+{
+    const int index = profile - MOS6581R2;
+    if ((index < 0) || (index >= NUM_PROFILES))
+        throw SIDError("Unknown chip profile");
+
+    static std::once_flag built[NUM_PROFILES];
+    static ProfileTables tables[NUM_PROFILES];
+
+    // Lookups after the first one don't take any lock
+    std::call_once(built[index], [index]
+    {
+        const ChipProfileConfig& config = profileConfigs[index];
+        WaveformCalculator* const calculator = WaveformCalculator::getInstance();
+
+        tables[index].config = &config;
+        tables[index].pulldown = calculator->buildPulldownTable(config.model, config.cws);
+        tables[index].fused = calculator->buildFusedTable(config.model, config.cws);
+    });
+
+    return tables[index];
+}
+
+}
+
+SID::SID(ChipModel model) :
+    filter(nullptr),
     resampler(nullptr),
-    cws(AVERAGE)
+    cws(AVERAGE),
+    quality(REFERENCE),
+    compactTables(false),
+    filter6581Curve(0.5),
+    filter6581Range(-1.),
+    filter8580Curve(0.5),
+    filterInput(0),
+    filterEnabled(true),
+    steadyCycles(0),
+    heldCycles(0)
 {
     voice[0].setOtherVoices(voice[2], voice[1]);
     voice[1].setOtherVoices(voice[0], voice[2]);
     voice[2].setOtherVoices(voice[1], voice[0]);
 
-    setChipModel(MOS8580);
+    std::fill(std::begin(registers), std::end(registers), 0);
+
+    setChipModel(model);
     reset();
 }
 
-SID::~SID()
+SID::~SID() = default;
+
+void SID::leaveSteadyState()
 {
-    delete filter6581;
-    delete filter8580;
+    for (unsigned int i = 0; i < heldCycles; i++)
+    {
+        filter->clock(voice[0], voice[1], voice[2], heldWav[0], heldWav[1], heldWav[2]);
+    }
+
+    heldCycles = 0;
+    steadyCycles = 0;
+}
+
+void SID::setCacheDirectory(const char* dir)
+{
+    FilterModelConfig::setCacheDirectory(dir);
 }
 
 void SID::setFilter6581Curve(double filterCurve)
 {
-    filter6581->setFilterCurve(filterCurve);
+    leaveSteadyState();
+
+    filter6581Curve = filterCurve;
+    if (filter6581)
+        filter6581->setFilterCurve(filterCurve);
 }
 
 void SID::setFilter6581Range(double adjustment)
 {
-    filter6581->setFilterRange(adjustment);
+    leaveSteadyState();
+
+    filter6581Range = adjustment;
+    if (filter6581)
+        filter6581->setFilterRange(adjustment);
 }
 
 void SID::setFilter8580Curve(double filterCurve)
 {
-    filter8580->setFilterCurve(filterCurve);
+    leaveSteadyState();
+
+    filter8580Curve = filterCurve;
+    if (filter8580)
+        filter8580->setFilterCurve(filterCurve);
 }
 
 void SID::enableFilter(bool enable)
 {
-    filter6581->enable(enable);
-    filter8580->enable(enable);
+    leaveSteadyState();
+
+    filterEnabled = enable;
+    filter->enable(enable);
+}
+
+void SID::syncFilter()
+{
+    filter->setQuality(quality);
+    filter->setCompactTables(compactTables);
+    filter->input(filterInput);
+    filter->writeFC_LO(registers[0x15]);
+    filter->writeFC_HI(registers[0x16]);
+    filter->writeRES_FILT(registers[0x17]);
+    filter->writeMODE_VOL(registers[0x18]);
+    filter->enable(filterEnabled);
 }
 
 void SID::voiceSync(bool sync)
@@ -216,16 +402,71 @@ void SID::voiceSync(bool sync)
 
 void SID::setChipModel(ChipModel model)
 {
+    if ((model != MOS6581) && (model != MOS8580))
+        throw SIDError("Unknown chip type");
+
+    WaveformCalculator* const calculator = WaveformCalculator::getInstance();
+
+    setModel(model,
+        calculator->buildPulldownTable(model, cws),
+        calculator->buildFusedTable(model, cws));
+}
+
+void SID::setChipProfile(ChipProfile profile)
+{
+    leaveSteadyState();
+
+    const ProfileTables& tables = getProfileTables(profile);
+    const ChipProfileConfig& config = *tables.config;
+
+    cws = config.cws;
+
+    if (config.model == MOS6581)
+    {
+        filter6581Curve = config.filterCurve;
+        filter6581Range = config.filterRange;
+        if (filter6581)
+        {
+            filter6581->setFilterCurve(filter6581Curve);
+            filter6581->setFilterRange(filter6581Range);
+        }
+    }
+    else
+    {
+        filter8580Curve = config.filterCurve;
+        if (filter8580)
+            filter8580->setFilterCurve(filter8580Curve);
+    }
+
+    setModel(config.model, tables.pulldown, tables.fused);
+}
+
+void SID::setModel(ChipModel model, matrix_t* pulldowntables, matrix_t* fusedtables)
+{
+    leaveSteadyState();
+
     switch (model)
     {
     case MOS6581:
-        filter = filter6581;
+        if (!filter6581)
+        {
+            filter6581.reset(new Filter6581());
+            filter6581->setFilterCurve(filter6581Curve);
+            if (filter6581Range >= 0.)
+                filter6581->setFilterRange(filter6581Range);
+        }
+        filter = filter6581.get();
         scaleFactor = 3;
         modelTTL = BUS_TTL_6581;
         break;
 
     case MOS8580:
-        filter = filter8580;
+        if (!filter8580)
+        {
+            filter8580.reset(new Filter8580());
+            filter8580->setFilterCurve(filter8580Curve);
+        }
+        filter = filter8580.get();
         scaleFactor = 5;
         modelTTL = BUS_TTL_8580;
         break;
@@ -236,51 +477,30 @@ void SID::setChipModel(ChipModel model)
 
     this->model = model;
 
-    // calculate waveform-related tables
-    matrix_t* wavetables = WaveformCalculator::getInstance()->getWaveTable();
-    matrix_t* pulldowntables = WaveformCalculator::getInstance()->buildPulldownTable(model, cws);
-
-    // calculate envelope DAC table
-    {
-        Dac dacBuilder(ENV_DAC_BITS);
-        dacBuilder.kinkedDac(model);
+    // the inactive filter missed any register writes
+    syncFilter();
 
-        for (unsigned int i = 0; i < (1 << ENV_DAC_BITS); i++)
-        {
-            envDAC[i] = static_cast<float>(dacBuilder.getOutput(i));
-        }
-    }
+    matrix_t* wavetables = WaveformCalculator::getInstance()->getWaveTable();
 
-    // calculate oscillator DAC table
+    const DacTables& dac = getDacTables(model);
     const bool is6581 = model == MOS6581;
 
-    {
-        Dac dacBuilder(OSC_DAC_BITS);
-        dacBuilder.kinkedDac(model);
-
-        //const double offset = dacBuilder.getOutput(is6581 ? OFFSET_6581 : OFFSET_8580);
-        const double offset = dacBuilder.getOutput(0x7ff, is6581);
-
-        for (unsigned int i = 0; i < (1 << OSC_DAC_BITS); i++)
-        {
-            const double dacValue = dacBuilder.getOutput(i, is6581);
-            oscDAC[i] = static_cast<float>(dacValue - offset);
-        }
-    }
-
     // set voice tables
     for (int i = 0; i < 3; i++)
     {
-        voice[i].setEnvDAC(envDAC);
-        voice[i].setWavDAC(oscDAC);
+        voice[i].setEnvDAC(dac.envDAC);
+        voice[i].setWavDAC(dac.oscDAC);
         voice[i].wave()->setModel(is6581);
         voice[i].wave()->setWaveformModels(wavetables);
         voice[i].wave()->setPulldownModels(pulldowntables);
+        voice[i].wave()->setFusedModels(fusedtables);
     }
 }
 
 void SID::setCombinedWaveforms(CombinedWaveforms cws)
 {
+    leaveSteadyState();
+
     switch (cws)
     {
     case AVERAGE:
@@ -296,22 +516,54 @@ void SID::setCombinedWaveforms(CombinedWaveforms cws)
 
     // rebuild waveform-related tables
     matrix_t* pulldowntables = WaveformCalculator::getInstance()->buildPulldownTable(model, cws);
+    matrix_t* fusedtables = WaveformCalculator::getInstance()->buildFusedTable(model, cws);
 
     for (int i = 0; i < 3; i++)
     {
         voice[i].wave()->setPulldownModels(pulldowntables);
+        voice[i].wave()->setFusedModels(fusedtables);
     }
 }
 
+void SID::setQuality(Quality quality)
+{
+    switch (quality)
+    {
+    case REFERENCE:
+    case FAST:
+    case DRAFT:
+        break;
+
+    default:
+        throw SIDError("Unknown quality level");
+    }
+
+    leaveSteadyState();
+
+    this->quality = quality;
+
+    filter->setQuality(quality);
+}
+
+void SID::setCompactTables(bool enable)
+{
+    leaveSteadyState();
+
+    compactTables = enable;
+
+    filter->setCompactTables(enable);
+}
+
 void SID::reset()
 {
+    leaveSteadyState();
+
     for (int i = 0; i < 3; i++)
     {
         voice[i].reset();
     }
 
-    filter6581->reset();
-    filter8580->reset();
+    filter->reset();
     externalFilter.reset();
 
     if (resampler.get())
@@ -321,13 +573,16 @@ void SID::reset()
 
     busValue = 0;
     busValueTtl = 0;
+    std::fill(std::begin(registers), std::end(registers), 0);
     voiceSync(false);
 }
 
 void SID::input(int value)
 {
-    filter6581->input(value);
-    filter8580->input(value);
+    leaveSteadyState();
+
+    filterInput = value;
+    filter->input(value);
 }
 
 unsigned char SID::read(int offset)
@@ -370,6 +625,14 @@ void SID::write(int offset, unsigned char value)
     busValue = value;
     busValueTtl = modelTTL;
 
+    if (offset < 0x19)
+    {
+        // Writing the same value again doesn't change the chip state
+        if (registers[offset] != value)
+            leaveSteadyState();
+        registers[offset] = value;
+    }
+
     switch (offset)
     {
     case 0x00: // Voice #1 frequency (Low-byte)
@@ -457,23 +720,19 @@ void SID::write(int offset, unsigned char value)
         break;
 
     case 0x15: // Filter cut off frequency (bits #0-#2)
-        filter6581->writeFC_LO(value);
-        filter8580->writeFC_LO(value);
+        filter->writeFC_LO(value);
         break;
 
     case 0x16: // Filter cut off frequency (bits #3-#10)
-        filter6581->writeFC_HI(value);
-        filter8580->writeFC_HI(value);
+        filter->writeFC_HI(value);
         break;
 
     case 0x17: // Filter control
-        filter6581->writeRES_FILT(value);
-        filter8580->writeRES_FILT(value);
+        filter->writeRES_FILT(value);
         break;
 
     case 0x18: // Volume and filter modes
-        filter6581->writeMODE_VOL(value);
-        filter8580->writeMODE_VOL(value);
+        filter->writeMODE_VOL(value);
         break;
 
     default:
@@ -484,8 +743,10 @@ void SID::write(int offset, unsigned char value)
     voiceSync(false);
 }
 
-void SID::setSamplingParameters(double clockFrequency, SamplingMethod method, double samplingFrequency)
+void SID::setSamplingParameters(double clockFrequency, SamplingMethod method, double samplingFrequency, double highestAccurateFrequency, bool densePhases)
 {
+    leaveSteadyState();
+
     externalFilter.setClockFrequency(clockFrequency);
 
     switch (method)
@@ -495,7 +756,13 @@ void SID::setSamplingParameters(double clockFrequency, SamplingMethod method, do
         break;
 
     case RESAMPLE:
-        resampler.reset(TwoPassSincResampler::create(clockFrequency, samplingFrequency));
+    case RESAMPLE_MINIMUM_PHASE:
+        if (highestAccurateFrequency > 0.45 * samplingFrequency)
+        {
+            throw SIDError("Passband frequency too high for the sampling frequency");
+        }
+        resampler.reset(CascadeResampler::create(clockFrequency, samplingFrequency, highestAccurateFrequency,
+            method == RESAMPLE_MINIMUM_PHASE, densePhases));
         break;
 
     default:
@@ -503,9 +770,28 @@ void SID::setSamplingParameters(double clockFrequency, SamplingMethod method, do
     }
 }
 
+double SID::getDelay() const
+{
+    return resampler ? resampler->delay() : 0.;
+}
+
+void SID::setRatioAdjustment(double ppm)
+{
+    if (std::fabs(ppm) > 10000.)
+    {
+        throw SIDError("Ratio adjustment out of range");
+    }
+
+    if (resampler)
+    {
+        resampler->setRatioAdjustment(ppm);
+    }
+}
+
 void SID::clockSilent(unsigned int cycles)
 {
     ageBusValue(cycles);
+    leaveSteadyState();
 
     while (cycles != 0)
     {
@@ -513,19 +799,44 @@ void SID::clockSilent(unsigned int cycles)
 
         if (delta_t > 0)
         {
-            for (int i = 0; i < delta_t; i++)
+            if (!ringModulation())
             {
-                // clock waveform generators (can affect OSC3)
-                voice[0].wave()->clock();
-                voice[1].wave()->clock();
-                voice[2].wave()->clock();
+                unsigned int wav[BLOCK_CYCLES];
 
-                voice[0].wave()->output();
-                voice[1].wave()->output();
-                voice[2].wave()->output();
+                for (int done = 0; done < delta_t; )
+                {
+                    const unsigned int n = std::min(static_cast<unsigned int>(delta_t - done), BLOCK_CYCLES);
+
+                    // clock waveform generators (can affect OSC3)
+                    voice[0].wave()->outputBlock(n, wav);
+                    voice[1].wave()->outputBlock(n, wav);
+                    voice[2].wave()->outputBlock(n, wav);
+
+                    done += n;
+                }
 
                 // clock ENV3 only
-                voice[2].envelope()->clock();
+                for (int i = 0; i < delta_t; i++)
+                {
+                    voice[2].envelope()->clock();
+                }
+            }
+            else
+            {
+                for (int i = 0; i < delta_t; i++)
+                {
+                    // clock waveform generators (can affect OSC3)
+                    voice[0].wave()->clock();
+                    voice[1].wave()->clock();
+                    voice[2].wave()->clock();
+
+                    voice[0].wave()->output();
+                    voice[1].wave()->output();
+                    voice[2].wave()->output();
+
+                    // clock ENV3 only
+                    voice[2].envelope()->clock();
+                }
             }
 
             cycles -= delta_t;
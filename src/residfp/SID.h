@@ -23,11 +23,13 @@
 #ifndef SIDFP_H
 #define SIDFP_H
 
+#include <algorithm>
 #include <memory>
 #include <cstdint>
 
 #include "siddefs-fp.h"
 #include "ExternalFilter.h"
+#include "Filter.h"
 #include "Potentiometer.h"
 #include "Voice.h"
 
@@ -61,14 +63,25 @@ public:
 class SID
 {
 private:
+    /// Number of cycles of waveform output computed at once
+    static constexpr unsigned int BLOCK_CYCLES = 64;
+
+    /**
+     * Cycles after which the filter state must repeat, with a constant output,
+     * to be at a fixed point. The voice inputs are dithered, so this
+     * is a whole period of the dither sequence, which #DRAFT quality
+     * only advances every other cycle.
+     */
+    static constexpr unsigned int STEADY_PERIOD = 2 * FilterModelConfig::DITHER_PERIOD;
+
     /// Currently active filter
     Filter* filter;
 
-    /// Filter used, if model is set to 6581
-    Filter6581* const filter6581;
+    /// Filter used, if model is set to 6581, created on first use
+    std::unique_ptr<Filter6581> filter6581;
 
-    /// Filter used, if model is set to 8580
-    Filter8580* const filter8580;
+    /// Filter used, if model is set to 8580, created on first use
+    std::unique_ptr<Filter8580> filter8580;
 
     /// Resampler used by audio generation code.
     std::unique_ptr<Resampler> resampler;
@@ -106,22 +119,41 @@ private:
     /// Currently selected combined waveforms strength.
     CombinedWaveforms cws;
 
+    /// Currently selected emulation quality.
+    Quality quality;
+
+    /// Use the compact filter tables.
+    bool compactTables;
+
+    /// Filter settings, applied when a filter is activated
+    //@{
+    double filter6581Curve;
+    double filter6581Range; ///< negative if never set
+    double filter8580Curve;
+    int filterInput;
+    bool filterEnabled;
+    //@}
+
+    /// Number of cycles the output has been steady, see #trackSteadyState
+    unsigned int steadyCycles;
+
+    /// Filter output during the steady stretch
+    int steadyOutput;
+
+    /// Filter state at the start of the steady stretch
+    Filter::State steadyState;
+
+    /// Cycles the filter has not been clocked while held, modulo #STEADY_PERIOD
+    unsigned int heldCycles;
+
+    /// Waveform outputs of the voices while held
+    unsigned int heldWav[3];
+
     /// Last written value
     unsigned char busValue;
 
-    /**
-     * Emulated nonlinearity of the envelope DAC.
-     *
-     * @See Dac
-     */
-    float envDAC[256];
-
-    /**
-     * Emulated nonlinearity of the oscillator DAC.
-     *
-     * @See Dac
-     */
-    float oscDAC[4096];
+    /// Last value written to each register
+    unsigned char registers[0x19];
 
 private:
     /**
@@ -139,10 +171,97 @@ private:
      */
     void voiceSync(bool sync);
 
+    /**
+     * Check whether all voice outputs are constant until the next register write.
+     */
+    bool voicesQuiescent() const
+    {
+        return voice[0].isQuiescent()
+            && voice[1].isQuiescent()
+            && voice[2].isQuiescent();
+    }
+
+    /**
+     * Track the filter output while the voices are quiescent.
+     * The inputs only vary with the dither, so once the filter gets back
+     * to the same state after #STEADY_PERIOD cycles of constant output
+     * it goes through the same states over and over, and the output
+     * is held at that value until the next change.
+     *
+     * @param output the filter output
+     */
+    void trackSteadyState(int output)
+    {
+        if ((steadyCycles == 0) || (output != steadyOutput))
+        {
+            steadyOutput = output;
+            steadyState = filter->getState();
+            steadyCycles = 1;
+        }
+        else if (++steadyCycles == STEADY_PERIOD + 1)
+        {
+            if (!(filter->getState() == steadyState))
+            {
+                // Not there yet, try again over the next period
+                steadyState = filter->getState();
+                steadyCycles = 1;
+            }
+        }
+    }
+
+    /**
+     * Track the output from scratch, as something changed.
+     * A held filter is first clocked through the part of its period
+     * it skipped, so that it carries on as if it had been clocked all along.
+     */
+    void leaveSteadyState();
+
+    /**
+     * Check whether any voice is ring modulated.
+     * Ring modulation reads the accumulator of the previous voice
+     * on each cycle so the waveforms can't be computed in blocks.
+     */
+    bool ringModulation()
+    {
+        return voice[0].wave()->readRingMod()
+            || voice[1].wave()->readRingMod()
+            || voice[2].wave()->readRingMod();
+    }
+
+    /**
+     * Bring the active filter up to date with the
+     * filter settings and the latched filter registers.
+     */
+    void syncFilter();
+
+    /**
+     * Switch to a chip model with the given waveform tables.
+     *
+     * @param model chip model to use
+     * @param pulldowntables combined waveforms pulldown tables
+     * @param fusedtables combined waveforms fused tables
+     */
+    void setModel(ChipModel model, matrix_t* pulldowntables, matrix_t* fusedtables);
+
 public:
-    SID();
+    /**
+     * Only the filter of the given chip model is created,
+     * the other one is built when the model is first switched to.
+     *
+     * @param model chip model to emulate
+     */
+    SID(ChipModel model = MOS8580);
     ~SID();
 
+    /**
+     * Set the directory where the filter lookup tables are cached,
+     * so that later processes can map them instead of building them.
+     * Only chip models first used afterwards are affected.
+     *
+     * @param dir the directory, empty to disable caching
+     */
+    static void setCacheDirectory(const char* dir);
+
     /**
      * Set chip model.
      *
@@ -156,6 +275,17 @@ public:
      */
     ChipModel getChipModel() const { return model; }
 
+    /**
+     * Set chip model, combined waveforms strength and filter settings
+     * at once from a chip profile.
+     * The tables of each profile are looked up once and shared,
+     * so switching profiles is cheap.
+     *
+     * @param profile chip profile to use
+     * @throw SIDError
+     */
+    void setChipProfile(ChipProfile profile);
+
     /**
      * Set combined waveforms strength.
      *
@@ -164,6 +294,46 @@ public:
      */
     void setCombinedWaveforms(CombinedWaveforms cws);
 
+    /**
+     * Get currently selected combined waveforms strength.
+     */
+    CombinedWaveforms getCombinedWaveforms() const { return cws; }
+
+    /**
+     * Set emulation quality.
+     *
+     * @param quality quality level to use
+     * @throw SIDError
+     */
+    void setQuality(Quality quality);
+
+    /**
+     * Get currently selected emulation quality.
+     */
+    Quality getQuality() const { return quality; }
+
+    /**
+     * Check whether the output is held: the voices are idle and the filter
+     * has settled at a fixed point, so it's not clocked anymore.
+     * The output stays the same until the next change.
+     */
+    bool isOutputHeld() const { return steadyCycles > STEADY_PERIOD; }
+
+    /**
+     * Use compact, linearly interpolated filter gain tables.
+     * The filter working set shrinks from about 1 MiB to 100 KiB,
+     * which helps on CPUs with small L2 caches at the cost
+     * of a few more operations per cycle.
+     *
+     * @param enable true to use the compact tables
+     */
+    void setCompactTables(bool enable);
+
+    /**
+     * Check whether the compact filter tables are used.
+     */
+    bool getCompactTables() const { return compactTables; }
+
     /**
      * SID reset.
      */
@@ -216,30 +386,58 @@ public:
      * The default end of passband frequency is pass_freq = 0.9*sample_freq/2
      * for sample frequencies up to ~ 44.1kHz, and 20kHz for higher sample frequencies.
      *
-     * For resampling, the ratio between the clock frequency and the sample frequency
-     * is limited as follows: 125*clock_freq/sample_freq < 16384
-     * E.g. provided a clock frequency of ~ 1MHz, the sample frequency can not be set
-     * lower than ~ 8kHz. A lower sample frequency would make the resampling code
-     * overfill its 16k sample ring buffer.
+     * For resampling, low sample frequencies are reached by halving the rate
+     * with short half-band filters before the SINC, whenever that is cheaper,
+     * so sample frequencies of a few hundred Hz are supported as well.
      *
      * The end of passband frequency is also limited: pass_freq <= 0.9*sample_freq/2
      *
      * E.g. for a 44.1kHz sampling rate the end of passband frequency
      * is limited to slightly below 20kHz.
      * This constraint ensures that the FIR table is not overfilled.
+     * A lower end of passband needs shorter filters, hence less computation.
+     *
+     * The linear phase filters of RESAMPLE delay the output by half their length,
+     * RESAMPLE_MINIMUM_PHASE uses minimum phase ones instead for live playback,
+     * see getDelay().
+     *
+     * The resampling filters interpolate between two convolutions by default.
+     * Dense phase tables need only one, for the same output give or take
+     * a few units, which is faster as long as the tables, up to about 300 KiB,
+     * stay in the cache.
      *
      * @param clockFrequency System clock frequency at Hz
      * @param method sampling method to use
      * @param samplingFrequency Desired output sampling rate
-     * @param highestAccurateFrequency
+     * @param highestAccurateFrequency end of passband frequency, 0 for the default
+     * @param densePhases use dense phase tables for resampling
      * @throw SIDError
      */
     void setSamplingParameters(
         double clockFrequency,
         SamplingMethod method,
-        double samplingFrequency
+        double samplingFrequency,
+        double highestAccurateFrequency = 0.,
+        bool densePhases = false
     );
 
+    /**
+     * Delay of the output of the sampling method, at low frequencies.
+     *
+     * @return the delay in seconds, 0 if the sampling parameters aren't set
+     */
+    double getDelay() const;
+
+    /**
+     * Nudge the output sampling rate, e.g. to follow the clock of the sound card.
+     * Unlike setSamplingParameters() this keeps the filters and the resampling history,
+     * so it can be called continuously. The adjustment is lost on setSamplingParameters().
+     *
+     * @param ppm adjustment in parts per million, positive for more samples, up to 1%
+     * @throw SIDError
+     */
+    void setRatioAdjustment(double ppm);
+
     /**
      * Clock SID forward using chosen output sampling algorithm.
      *
@@ -331,23 +529,100 @@ int SID::clock(unsigned int cycles, short* buf)
 
         if (likely(delta_t > 0))
         {
-            for (unsigned int i = 0; i < delta_t; i++)
+            if (likely(!ringModulation()))
             {
-                // clock waveform generators
-                voice[0].wave()->clock();
-                voice[1].wave()->clock();
-                voice[2].wave()->clock();
-
-                // clock envelope generators
-                voice[0].envelope()->clock();
-                voice[1].envelope()->clock();
-                voice[2].envelope()->clock();
-
-                const int sidOutput = static_cast<int>(filter->clock(voice[0], voice[1], voice[2]));
-                const int c64Output = externalFilter.clock(sidOutput + INT16_MIN);
-                if (unlikely(resampler->input(c64Output)))
+                // Waveform and analog outputs are computed in blocks
+                unsigned int wav[3][BLOCK_CYCLES];
+                int c64Output[BLOCK_CYCLES];
+
+                for (unsigned int done = 0; done < delta_t; )
+                {
+                    const unsigned int n = std::min(delta_t - done, BLOCK_CYCLES);
+
+                    const bool quiescent = voicesQuiescent();
+                    if (!quiescent)
+                        leaveSteadyState();
+
+                    voice[0].wave()->outputBlock(n, wav[0]);
+                    voice[1].wave()->outputBlock(n, wav[1]);
+                    voice[2].wave()->outputBlock(n, wav[2]);
+
+                    if (unlikely(isOutputHeld()))
+                    {
+                        // The filter is at a fixed point, only the envelope
+                        // rate counters keep running
+                        for (unsigned int i = 0; i < n; i++)
+                        {
+                            voice[0].envelope()->clock();
+                            voice[1].envelope()->clock();
+                            voice[2].envelope()->clock();
+                        }
+
+                        heldCycles = (heldCycles + n) & (STEADY_PERIOD - 1);
+                        heldWav[0] = wav[0][n - 1];
+                        heldWav[1] = wav[1][n - 1];
+                        heldWav[2] = wav[2][n - 1];
+
+                        const int sidOutput = steadyOutput + INT16_MIN;
+
+                        if (externalFilter.isSettled(sidOutput))
+                        {
+                            // So is the external filter, which takes much longer
+                            s += resampler->processConstant(externalFilter.clock(sidOutput), static_cast<int>(n), buf + s, scaleFactor);
+                            done += n;
+                            continue;
+                        }
+
+                        for (unsigned int i = 0; i < n; i++)
+                        {
+                            c64Output[i] = externalFilter.clock(sidOutput);
+                        }
+                    }
+                    else
+                    {
+                        for (unsigned int i = 0; i < n; i++)
+                        {
+                            // clock envelope generators
+                            voice[0].envelope()->clock();
+                            voice[1].envelope()->clock();
+                            voice[2].envelope()->clock();
+
+                            const int sidOutput = static_cast<int>(filter->clock(voice[0], voice[1], voice[2], wav[0][i], wav[1][i], wav[2][i]));
+                            c64Output[i] = externalFilter.clock(sidOutput + INT16_MIN);
+                            if (unlikely(quiescent))
+                            {
+                                trackSteadyState(sidOutput);
+                            }
+                        }
+                    }
+
+                    s += resampler->process(c64Output, static_cast<int>(n), buf + s, scaleFactor);
+
+                    done += n;
+                }
+            }
+            else
+            {
+                leaveSteadyState();
+
+                for (unsigned int i = 0; i < delta_t; i++)
                 {
-                    buf[s++] = resampler->getOutput(scaleFactor);
+                    // clock waveform generators
+                    voice[0].wave()->clock();
+                    voice[1].wave()->clock();
+                    voice[2].wave()->clock();
+
+                    // clock envelope generators
+                    voice[0].envelope()->clock();
+                    voice[1].envelope()->clock();
+                    voice[2].envelope()->clock();
+
+                    const int sidOutput = static_cast<int>(filter->clock(voice[0], voice[1], voice[2]));
+                    const int c64Output = externalFilter.clock(sidOutput + INT16_MIN);
+                    if (unlikely(resampler->input(c64Output)))
+                    {
+                        buf[s++] = resampler->getOutput(scaleFactor);
+                    }
                 }
             }
 
@@ -41,10 +41,10 @@ private:
     EnvelopeGenerator envelopeGenerator;
 
     /// The DAC LUT for analog waveform output
-    float* wavDAC; //-V730_NOINIT this is initialized in the SID constructor
+    const float* wavDAC; //-V730_NOINIT this is initialized in the SID constructor
 
     /// The DAC LUT for analog envelope output
-    float* envDAC; //-V730_NOINIT this is initialized in the SID constructor
+    const float* envDAC; //-V730_NOINIT this is initialized in the SID constructor
 
 public:
     /**
@@ -64,7 +64,19 @@ public:
     RESID_INLINE
     float output()
     {
-        unsigned int const wav = waveformGenerator.output();
+        return output(waveformGenerator.output());
+    }
+
+    /**
+     * Amplitude modulated output of an already computed waveform.
+     *
+     * @param wav the waveform generator digital output
+     * @return the voice analog output
+     * @see WaveformGenerator::outputBlock
+     */
+    RESID_INLINE
+    float output(unsigned int wav) const
+    {
         unsigned int const env = envelopeGenerator.output();
 
         // DAC imperfections are emulated by using the digital output
@@ -78,7 +90,7 @@ public:
      *
      * @param dac
      */
-    void setWavDAC(float* dac) { wavDAC = dac; }
+    void setWavDAC(const float* dac) { wavDAC = dac; }
 
     /**
      * Set the analog DAC emulation for envelope.
@@ -86,7 +98,7 @@ public:
      *
      * @param dac
      */
-    void setEnvDAC(float* dac) { envDAC = dac; }
+    void setEnvDAC(const float* dac) { envDAC = dac; }
 
     /**
      * Set the modulator voice.
@@ -98,6 +110,11 @@ public:
         waveformGenerator.setOtherWaveforms(prev.wave(), next.wave());
     }
 
+    /**
+     * Check whether the voice output is constant until the next register write.
+     */
+    bool isQuiescent() const { return waveformGenerator.isQuiescent() && envelopeGenerator.isFrozen(); }
+
     WaveformGenerator* wave() { return &waveformGenerator; }
 
     EnvelopeGenerator* envelope() { return &envelopeGenerator; }
@@ -23,7 +23,7 @@
 
 #include "sidcxx11.h"
 
-#include <map>
+#include <memory>
 #include <mutex>
 #include <cmath>
 
@@ -45,11 +45,19 @@ using CombinedWaveformConfig = struct
     float distance2;
 };
 
-using cw_cache_t = std::map<const CombinedWaveformConfig*, matrix_t>;
-
-cw_cache_t PULLDOWN_CACHE;
+/**
+ * Combined waveform tables of a chip model and strength,
+ * built on first use and never changed afterwards.
+ */
+struct CombinedWaveformTables
+{
+    std::once_flag built;
+    std::unique_ptr<matrix_t> pulldown;
+    std::unique_ptr<matrix_t> fused;
+};
 
-std::mutex PULLDOWN_CACHE_Lock;
+/// Tables by chip model and combined waveforms strength
+CombinedWaveformTables CW_TABLES[2][3];
 
 WaveformCalculator* WaveformCalculator::getInstance()
 {
@@ -247,35 +255,40 @@ WaveformCalculator::WaveformCalculator() :
     }
 }
 
-matrix_t* WaveformCalculator::buildPulldownTable(ChipModel model, CombinedWaveforms cws)
+static int getStrengthIndex(CombinedWaveforms cws)
 {
-    std::lock_guard<std::mutex> lock(PULLDOWN_CACHE_Lock);
-
-    const int modelIdx = model == MOS6581 ? 0 : 1;
-    const CombinedWaveformConfig* cfgArray;
-
     switch (cws)
     {
     default:
     case AVERAGE:
-        cfgArray = configAverage[modelIdx];
-        break;
+        return 0;
     case WEAK:
-        cfgArray = configWeak[modelIdx];
-        break;
+        return 1;
     case STRONG:
-        cfgArray = configStrong[modelIdx];
-        break;
+        return 2;
     }
+}
 
-    cw_cache_t::iterator lb = PULLDOWN_CACHE.lower_bound(cfgArray);
-
-    if (lb != PULLDOWN_CACHE.end() && !(PULLDOWN_CACHE.key_comp()(cfgArray, lb->first)))
+static const CombinedWaveformConfig* getConfig(int modelIdx, int cwsIdx)
+{
+    switch (cwsIdx)
     {
-        return &(lb->second);
+    default:
+    case 0:
+        return configAverage[modelIdx];
+    case 1:
+        return configWeak[modelIdx];
+    case 2:
+        return configStrong[modelIdx];
     }
+}
 
-    matrix_t pdTable(5, 4096);
+/**
+ * Calculate the pulldown table of a combined waveform configuration.
+ */
+static matrix_t* calculatePulldownTable(const CombinedWaveformConfig* cfgArray)
+{
+    matrix_t* pdTable = new matrix_t(5, 4096);
 
     for (int wav = 0; wav < 5; wav++)
     {
@@ -293,11 +306,82 @@ matrix_t* WaveformCalculator::buildPulldownTable(ChipModel model, CombinedWavefo
 
         for (unsigned int idx = 0; idx < (1u << 12); idx++)
         {
-            pdTable[wav][idx] = calculatePulldown(distancetable, cfg.topbit, cfg.pulsestrength, cfg.threshold, idx);
+            (*pdTable)[wav][idx] = calculatePulldown(distancetable, cfg.topbit, cfg.pulsestrength, cfg.threshold, idx);
         }
     }
 
-    return &(PULLDOWN_CACHE.emplace_hint(lb, cw_cache_t::value_type(cfgArray, pdTable))->second);
+    return pdTable;
+}
+
+/**
+ * Fold a pulldown table into the waveform table.
+ */
+static matrix_t* calculateFusedTable(matrix_t& wftable, matrix_t& pdTable)
+{
+    matrix_t* fusedTable = new matrix_t(8, 4096);
+
+    for (unsigned int waveform = 0; waveform < 8; waveform++)
+    {
+        // Same pulldown selection as in WaveformGenerator::writeCONTROL_REG
+        // for the waveforms not including noise
+        const short* pulldown;
+        switch (waveform)
+        {
+        case 3:
+            pulldown = pdTable[0];
+            break;
+        case 5:
+            pulldown = pdTable[1];
+            break;
+        case 6:
+            pulldown = pdTable[2];
+            break;
+        case 7:
+            pulldown = pdTable[3];
+            break;
+        default:
+            pulldown = nullptr;
+            break;
+        }
+
+        for (unsigned int idx = 0; idx < (1u << 12); idx++)
+        {
+            const short value = wftable[waveform & 0x3][idx];
+            (*fusedTable)[waveform][idx] = pulldown != nullptr ? pulldown[value] : value;
+        }
+    }
+
+    return fusedTable;
+}
+
+/**
+ * Get the tables of a chip model and strength, building them on first use.
+ * Once built, the lookup takes no lock.
+ */
+static CombinedWaveformTables& getTables(matrix_t& wftable, ChipModel model, CombinedWaveforms cws)
+{
+    const int modelIdx = model == MOS6581 ? 0 : 1;
+    const int cwsIdx = getStrengthIndex(cws);
+
+    CombinedWaveformTables& tables = CW_TABLES[modelIdx][cwsIdx];
+
+    std::call_once(tables.built, [&]
+    {
+        tables.pulldown.reset(calculatePulldownTable(getConfig(modelIdx, cwsIdx)));
+        tables.fused.reset(calculateFusedTable(wftable, *tables.pulldown));
+    });
+
+    return tables;
+}
+
+matrix_t* WaveformCalculator::buildPulldownTable(ChipModel model, CombinedWaveforms cws)
+{
+    return getTables(wftable, model, cws).pulldown.get();
+}
+
+matrix_t* WaveformCalculator::buildFusedTable(ChipModel model, CombinedWaveforms cws)
+{
+    return getTables(wftable, model, cws).fused.get();
 }
 
 } // namespace reSIDfp
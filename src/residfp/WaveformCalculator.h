@@ -106,12 +106,27 @@ public:
 
     /**
      * Build pulldown table for use by WaveformGenerator.
+     * The tables are built once for each chip model and strength,
+     * later calls return them without locking.
      *
      * @param model Chip model to use
      * @param cws strength of combined waveforms
      * @return Pulldown table
      */
     matrix_t* buildPulldownTable(ChipModel model, CombinedWaveforms cws);
+
+    /**
+     * Build fused waveform table for use by WaveformGenerator.
+     * For each waveform not including noise, the pulldown is folded
+     * into the waveform table so that the output can be computed
+     * with a single lookup. As pulldown of 0 is 0 the pulse mask
+     * can be applied to the fused value.
+     *
+     * @param model Chip model to use
+     * @param cws strength of combined waveforms
+     * @return Fused waveform table, indexed by waveform
+     */
+    matrix_t* buildFusedTable(ChipModel model, CombinedWaveforms cws);
 };
 
 } // namespace reSIDfp
@@ -24,6 +24,8 @@
 
 #include "WaveformGenerator.h"
 
+#include <algorithm>
+
 namespace reSIDfp
 {
 
@@ -328,11 +330,154 @@ void WaveformGenerator::set_noise_output()
 void WaveformGenerator::setWaveformModels(matrix_t* models)
 {
     model_wave = models;
+    setWaveformTables();
 }
 
 void WaveformGenerator::setPulldownModels(matrix_t* models)
 {
     model_pulldown = models;
+    setWaveformTables();
+}
+
+void WaveformGenerator::setFusedModels(matrix_t* models)
+{
+    model_fused = models;
+    setWaveformTables();
+}
+
+void WaveformGenerator::setWaveformTables()
+{
+    // Not all the models are set yet
+    if (model_wave == nullptr || model_pulldown == nullptr || model_fused == nullptr)
+        return;
+
+    wave = (*model_wave)[waveform & 0x3];
+    fused = (*model_fused)[waveform & 0x7];
+    // We assume tha combinations including noise
+    // behave the same as without
+    switch (waveform & 0x7)
+    {
+    case 3:
+        pulldown = (*model_pulldown)[0];
+        break;
+    case 4:
+        pulldown = (waveform & 0x8) ? (*model_pulldown)[4] : nullptr;
+        break;
+    case 5:
+        pulldown = (*model_pulldown)[1];
+        break;
+    case 6:
+        pulldown = (*model_pulldown)[2];
+        break;
+    case 7:
+        pulldown = (*model_pulldown)[3];
+        break;
+    default:
+        pulldown = nullptr;
+        break;
+    }
+
+    setTriSawPipelinePulldown();
+}
+
+unsigned int WaveformGenerator::eventFreeCycles(unsigned int n) const
+{
+    if (test || (shift_pipeline != 0) || (ring_msb_mask != 0) || (waveform > 0x8))
+        return 0;
+
+    // The sawtooth MSB may be pulled down by combined waveforms
+    if (is6581 && (waveform & 0x2) && (pulldown != nullptr))
+        return 0;
+
+    if ((waveform == 0) && (floating_output_ttl != 0))
+        n = std::min(n, floating_output_ttl - 1);
+
+    if (freq != 0)
+    {
+        // Cycles until bit 19 is set high again
+        const unsigned int acc = accumulator & 0xfffff;
+        const unsigned int distance = (acc < 0x80000 ? 0x80000 : 0x180000) - acc;
+        n = std::min(n, (distance + freq - 1) / freq - 1);
+    }
+
+    return n;
+}
+
+void WaveformGenerator::outputBlock(unsigned int n, unsigned int* out)
+{
+    while (n != 0)
+    {
+        const unsigned int cycles = eventFreeCycles(n);
+
+        if (cycles == 0)
+        {
+            clock();
+            *out++ = output();
+            n--;
+            continue;
+        }
+
+        const unsigned int accumulator_old = accumulator;
+
+        if (waveform != 0)
+        {
+            // Accumulator values are computed in closed form,
+            // the carry out of bit 23 being lost in the mask.
+            for (unsigned int i = 0; i < cycles; i++)
+            {
+                out[i] = ((accumulator_old + (i + 1) * freq) & 0xffffff) >> 12;
+            }
+
+            // Pure noise has a constant output here, with no pulldown
+            const short* table = (waveform == 0x8) ? wave : fused;
+            const unsigned int mask = no_noise_or_noise_output;
+            unsigned int pulse = pulse_output;
+            for (unsigned int i = 0; i < cycles; i++)
+            {
+                const unsigned int ix = out[i];
+                out[i] = table[ix] & (no_pulse | pulse) & mask;
+                pulse = (ix >= pw) ? 0xfff : 0x000;
+            }
+
+            waveform_output = out[cycles - 1];
+
+            if ((waveform & 3) && !is6581)
+            {
+                // The tri/saw pipeline only depends on the last two cycles
+                const unsigned int ix_prev = ((accumulator_old + (cycles - 1) * freq) & 0xffffff) >> 12;
+                const unsigned int ix_last = ((accumulator_old + cycles * freq) & 0xffffff) >> 12;
+                const unsigned int tri_saw_prev = (cycles > 1) ? fused[ix_prev] : tri_saw_pipeline_pulldown;
+                const unsigned int pulse_prev = (cycles > 1) ? ((ix_prev >= pw) ? 0xfff : 0x000) : pulse_output;
+
+                osc3 = tri_saw_prev & (no_pulse | pulse_prev);
+                tri_saw_pipeline = wave[ix_last];
+                tri_saw_pipeline_pulldown = fused[ix_last];
+            }
+            else
+            {
+                osc3 = waveform_output;
+            }
+        }
+        else
+        {
+            for (unsigned int i = 0; i < cycles; i++)
+            {
+                out[i] = waveform_output;
+            }
+
+            if (floating_output_ttl != 0)
+                floating_output_ttl -= cycles;
+        }
+
+        // The cycle before the last one gives the MSB transition
+        const unsigned int accumulator_prev = (accumulator_old + (cycles - 1) * freq) & 0xffffff;
+        accumulator = (accumulator_old + cycles * freq) & 0xffffff;
+        msb_rising = ((~accumulator_prev & accumulator) & 0x800000) != 0;
+        pulse_output = ((accumulator >> 12) >= pw) ? 0xfff : 0x000;
+
+        out += cycles;
+        n -= cycles;
+    }
 }
 
 void WaveformGenerator::synchronize() const
@@ -365,31 +510,7 @@ void WaveformGenerator::writeCONTROL_REG(unsigned char control)
 
     if (waveform != waveform_prev)
     {
-        // Set up waveform tables
-        wave = (*model_wave)[waveform & 0x3];
-        // We assume tha combinations including noise
-        // behave the same as without
-        switch (waveform & 0x7)
-        {
-        case 3:
-            pulldown = (*model_pulldown)[0];
-            break;
-        case 4:
-            pulldown = (waveform & 0x8) ? (*model_pulldown)[4] : nullptr;
-            break;
-        case 5:
-            pulldown = (*model_pulldown)[1];
-            break;
-        case 6:
-            pulldown = (*model_pulldown)[2];
-            break;
-        case 7:
-            pulldown = (*model_pulldown)[3];
-            break;
-        default:
-            pulldown = nullptr;
-            break;
-        }
+        setWaveformTables();
 
         // no_noise and no_pulse are used in set_waveform_output() as bitmasks to
         // only let the noise or pulse influence the output when the noise or pulse
@@ -466,6 +587,8 @@ void WaveformGenerator::reset()
 
     wave = model_wave ? (*model_wave)[0] : nullptr;
     pulldown = nullptr;
+    fused = model_fused ? (*model_fused)[0] : nullptr;
+    setTriSawPipelinePulldown();
 
     ring_msb_mask = 0;
     no_noise = 0xfff;
@@ -95,10 +95,14 @@ class WaveformGenerator
 private:
     matrix_t* model_wave = nullptr;
     matrix_t* model_pulldown = nullptr;
+    matrix_t* model_fused = nullptr;
 
     short* wave = nullptr;
     short* pulldown = nullptr;
 
+    /// Waveform table with pulldown folded in, valid for waveforms without noise.
+    short* fused = nullptr;
+
     // PWout = (PWn/40.95)%
     unsigned int pw = 0;
 
@@ -131,6 +135,9 @@ private:
     /// 8580 tri/saw pipeline
     unsigned int tri_saw_pipeline = 0x555;
 
+    /// 8580 tri/saw pipeline with the current pulldown applied
+    unsigned int tri_saw_pipeline_pulldown = 0x555;
+
     /// The OSC3 value
     unsigned int osc3 = 0;
 
@@ -173,9 +180,30 @@ private:
 
     void shiftregBitfade();
 
+    /**
+     * Point the active tables at the current waveform, so that
+     * changing the models takes effect without a control register write.
+     */
+    void setWaveformTables();
+
+    void setTriSawPipelinePulldown()
+    {
+        tri_saw_pipeline_pulldown = (pulldown != nullptr) ? pulldown[tri_saw_pipeline] : tri_saw_pipeline;
+    }
+
+    /**
+     * Number of upcoming cycles, up to n, that can be computed in bulk
+     * by #outputBlock: no noise or test handling, no ring modulation,
+     * no accumulator MSB pulldown and no bit 19 rising edge.
+     *
+     * @param n maximum number of cycles
+     */
+    unsigned int eventFreeCycles(unsigned int n) const;
+
 public:
     void setWaveformModels(matrix_t* models);
     void setPulldownModels(matrix_t* models);
+    void setFusedModels(matrix_t* models);
 
     void setOtherWaveforms(const WaveformGenerator* prev, WaveformGenerator* next)
     {
@@ -250,6 +278,18 @@ public:
      */
     unsigned int output();
 
+    /**
+     * Clock the generator and compute the 12-bit waveform output
+     * for n cycles.
+     * Equivalent to calling clock() and output() n times, but stretches
+     * without events are computed in closed form, as long as the
+     * accumulator of the ring modulating voice is not needed.
+     *
+     * @param n number of cycles
+     * @param out buffer for the n waveform outputs
+     */
+    void outputBlock(unsigned int n, unsigned int* out);
+
     /**
      * Read OSC3 value.
      */
@@ -270,6 +310,23 @@ public:
      */
     bool readTest() const { return test; }
 
+    /**
+     * Read ring modulation status.
+     */
+    bool readRingMod() const { return ring_msb_mask != 0; }
+
+    /**
+     * Check whether the waveform output is constant until the next register write:
+     * either no waveform is selected and the floating output has faded,
+     * or the test bit holds the accumulator of a waveform without noise.
+     */
+    bool isQuiescent() const
+    {
+        return (waveform == 0)
+            ? (floating_output_ttl == 0)
+            : (test && (waveform < 0x8) && (ring_msb_mask == 0));
+    }
+
     /**
      * Read sync value from following voice.
      */
@@ -356,25 +413,48 @@ unsigned int WaveformGenerator::output()
     {
         const unsigned int ix = (accumulator ^ (~prevVoice->accumulator & ring_msb_mask)) >> 12;
 
-        // The bit masks no_pulse and no_noise are used to achieve branch-free
-        // calculation of the output value.
-        waveform_output = wave[ix] & (no_pulse | pulse_output) & no_noise_or_noise_output;
-        if (pulldown != nullptr)
-            waveform_output = pulldown[waveform_output];
-
-        // Triangle/Sawtooth output is delayed half cycle on 8580.
-        // This will appear as a one cycle delay on OSC3 as it is latched
-        // in the first phase of the clock.
-        if ((waveform & 3) && !is6581)
+        if (likely(waveform < 0x8))
         {
-            osc3 = tri_saw_pipeline & (no_pulse | pulse_output) & no_noise_or_noise_output;
-            if (pulldown != nullptr)
-                osc3 = pulldown[osc3];
-            tri_saw_pipeline = wave[ix];
+            // Without noise the only mask is the pulse, which is either
+            // all zeros or all ones, so the pulldown is already folded
+            // into the table.
+            const unsigned int output = fused[ix];
+            waveform_output = output & (no_pulse | pulse_output);
+
+            // Triangle/Sawtooth output is delayed half cycle on 8580.
+            // This will appear as a one cycle delay on OSC3 as it is latched
+            // in the first phase of the clock.
+            if ((waveform & 3) && !is6581)
+            {
+                osc3 = tri_saw_pipeline_pulldown & (no_pulse | pulse_output);
+                tri_saw_pipeline = wave[ix];
+                tri_saw_pipeline_pulldown = output;
+            }
+            else
+            {
+                osc3 = waveform_output;
+            }
         }
         else
         {
-            osc3 = waveform_output;
+            // The bit masks no_pulse and no_noise are used to achieve branch-free
+            // calculation of the output value.
+            waveform_output = wave[ix] & (no_pulse | pulse_output) & no_noise_or_noise_output;
+            if (pulldown != nullptr)
+                waveform_output = pulldown[waveform_output];
+
+            if ((waveform & 3) && !is6581)
+            {
+                osc3 = tri_saw_pipeline & (no_pulse | pulse_output) & no_noise_or_noise_output;
+                if (pulldown != nullptr)
+                    osc3 = pulldown[osc3];
+                tri_saw_pipeline = wave[ix];
+                setTriSawPipelinePulldown();
+            }
+            else
+            {
+                osc3 = waveform_output;
+            }
         }
 
         // In the 6581 the top bit of the accumulator may be driven low by combined waveforms
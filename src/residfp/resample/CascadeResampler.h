@@ -0,0 +1,216 @@
+/*
+ * This file is part of libsidplayfp, a SID player engine.
+ *
+ * Copyright 2011-2024 Leandro Nini <drfiemost@users.sourceforge.net>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+#ifndef CASCADERESAMPLER_H
+#define CASCADERESAMPLER_H
+
+#include <algorithm>
+#include <cmath>
+#include <memory>
+#include <vector>
+
+#include "Resampler.h"
+#include "HalfBandDecimator.h"
+#include "TwoPassSincResampler.h"
+
+#include "sidcxx11.h"
+
+namespace reSIDfp
+{
+
+/**
+ * Chain of half-band decimators followed by the SINC resampling.
+ *
+ * Each decimator halves the rate, and with it the work of the following stages,
+ * while the ring buffers stay small. This allows output rates
+ * far below what a SINC resampler alone can handle.
+ */
+class CascadeResampler final : public Resampler
+{
+private:
+    std::vector<std::unique_ptr<HalfBandDecimator>> stages;
+    std::unique_ptr<Resampler> const last;
+
+private:
+    /// Whether there are samples and they're all the same
+    static bool isConstant(const int* samples, int n)
+    {
+        return (n > 0) && std::all_of(samples + 1, samples + n, [samples](int x) { return x == samples[0]; });
+    }
+
+    CascadeResampler(double clockFrequency, double highestAccurateFrequency, int numStages, Resampler* last) :
+        last(last)
+    {
+        double frequency = clockFrequency;
+        for (int i = 0; i < numStages; i++)
+        {
+            stages.emplace_back(new HalfBandDecimator(frequency, highestAccurateFrequency));
+            frequency /= 2.;
+        }
+    }
+
+public:
+    /**
+     * Named constructor.
+     *
+     * Picks the number of half-band decimators, and the layout of the SINC resampling
+     * at the reduced rate, that need the fewest multiply-accumulates per output sample.
+     * Without decimators this is the same as TwoPassSincResampler::create.
+     *
+     * @param clockFrequency System clock frequency at Hz
+     * @param samplingFrequency Desired output sampling rate
+     * @param highestAccurateFrequency passband frequency limit, the default one if not positive
+     * @param minimumPhase use minimum phase filters for the SINC resampling, for a lower delay
+     * @param densePhases use dense tables and a single convolution per sample for the SINC resampling
+     */
+    static Resampler* create(double clockFrequency, double samplingFrequency, double highestAccurateFrequency = 0., bool minimumPhase = false, bool densePhases = false)
+    {
+        const double halfFreq = (highestAccurateFrequency > 0.)
+            ? highestAccurateFrequency : TwoPassSincResampler::defaultPassband(samplingFrequency);
+
+        double intermediateFrequency;
+        double bestCost = TwoPassSincResampler::bestLayout(clockFrequency, samplingFrequency, halfFreq, intermediateFrequency);
+        int bestStages = 0;
+
+        double stagesCost = 0.;
+        double frequency = clockFrequency;
+        for (int numStages = 1; frequency / 2. >= samplingFrequency; numStages++)
+        {
+            // Each decimator produces frequency/(2*samplingFrequency) samples per output sample
+            stagesCost += HalfBandDecimator::cost(frequency, halfFreq) * frequency / (2. * samplingFrequency);
+            frequency /= 2.;
+
+            const double cost = stagesCost
+                + TwoPassSincResampler::bestLayout(frequency, samplingFrequency, halfFreq, intermediateFrequency);
+
+            if (cost < bestCost)
+            {
+                bestCost = cost;
+                bestStages = numStages;
+            }
+        }
+
+        Resampler* const sinc = TwoPassSincResampler::create(
+            std::ldexp(clockFrequency, -bestStages), samplingFrequency, halfFreq, minimumPhase, densePhases);
+
+        if (bestStages == 0)
+            return sinc;
+
+        return new CascadeResampler(clockFrequency, halfFreq, bestStages, sinc);
+    }
+
+    bool input(int sample) override
+    {
+        for (auto& stage : stages)
+        {
+            if (!stage->input(sample))
+                return false;
+            sample = stage->output();
+        }
+
+        return last->input(sample);
+    }
+
+    int process(const int* in, int n, short* out, int scaleFactor) override
+    {
+        int buffer[PROCESS_CHUNK];
+        int s = 0;
+
+        while (n > 0)
+        {
+            const int len = std::min(n, PROCESS_CHUNK);
+
+            // The decimators work in place, halving the samples each time
+            int m = stages[0]->process(in, len, buffer);
+            for (std::size_t i = 1; i < stages.size(); i++)
+            {
+                m = stages[i]->process(buffer, m, buffer);
+            }
+
+            s += last->process(buffer, m, out + s, scaleFactor);
+
+            in += len;
+            n -= len;
+        }
+
+        return s;
+    }
+
+    int processConstant(int sample, int n, short* out, int scaleFactor) override
+    {
+        int buffer[PROCESS_CHUNK];
+        int s = 0;
+
+        while (n > 0)
+        {
+            const int len = std::min(n, PROCESS_CHUNK);
+
+            // Once the decimators have settled their outputs are constant too
+            int m = stages[0]->processConstant(sample, len, buffer);
+            for (std::size_t i = 1; i < stages.size(); i++)
+            {
+                m = isConstant(buffer, m)
+                    ? stages[i]->processConstant(buffer[0], m, buffer)
+                    : stages[i]->process(buffer, m, buffer);
+            }
+
+            s += isConstant(buffer, m)
+                ? last->processConstant(buffer[0], m, out + s, scaleFactor)
+                : last->process(buffer, m, out + s, scaleFactor);
+
+            n -= len;
+        }
+
+        return s;
+    }
+
+    int output() const override
+    {
+        return last->output();
+    }
+
+    double delay() const override
+    {
+        double total = last->delay();
+        for (auto& stage : stages)
+        {
+            total += stage->delay();
+        }
+        return total;
+    }
+
+    void setRatioAdjustment(double ppm) override
+    {
+        last->setRatioAdjustment(ppm);
+    }
+
+    void reset() override
+    {
+        for (auto& stage : stages)
+        {
+            stage->reset();
+        }
+        last->reset();
+    }
+};
+
+} // namespace reSIDfp
+
+#endif
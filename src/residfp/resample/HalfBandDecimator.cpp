@@ -0,0 +1,264 @@
+/*
+ * This file is part of libsidplayfp, a SID player engine.
+ *
+ * Copyright 2011-2024 Leandro Nini <drfiemost@users.sourceforge.net>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+#include "HalfBandDecimator.h"
+
+#include <algorithm>
+#include <iterator>
+#include <limits>
+#include <cassert>
+#include <cmath>
+#include <cstring>
+
+namespace reSIDfp
+{
+
+namespace
+{
+
+#ifdef M_PI
+constexpr double PI = M_PI;
+#else
+constexpr double PI = 3.14159265358979323846;
+#endif
+
+}
+
+int HalfBandDecimator::firLength(double inputFrequency, double highestAccurateFrequency)
+{
+    // The transition band goes from the passband to its mirror image
+    // around a quarter of the input rate.
+    const double dw = (1. - 4. * highestAccurateFrequency / inputFrequency) * PI;
+
+    // The order of a half-band filter is 2 modulo 4, so that the taps
+    // at both ends fall on odd positions, where the coefficients are not zero.
+    int N = SincResampler::kaiserOrder(dw);
+    N += (6 - (N & 3)) & 3;
+
+    return N + 1;
+}
+
+double HalfBandDecimator::cost(double inputFrequency, double highestAccurateFrequency)
+{
+    if (4. * highestAccurateFrequency >= inputFrequency)
+        return std::numeric_limits<double>::infinity();
+
+    const int firN = firLength(inputFrequency, highestAccurateFrequency);
+
+    // One multiplication per pair of symmetric nonzero taps,
+    // unless the ring buffer can't hold the filter
+    return (firN < RINGSIZE)
+        ? static_cast<double>(TAP_WEIGHT * ((firN + 1) / 4) + OUTPUT_OVERHEAD)
+        : std::numeric_limits<double>::infinity();
+}
+
+HalfBandDecimator::HalfBandDecimator(double inputFrequency, double highestAccurateFrequency)
+{
+    const int firN = firLength(inputFrequency, highestAccurateFrequency);
+
+    // Check whether the sample ring buffer would overflow.
+    assert(firN < RINGSIZE);
+
+    const int center = firN / 2;
+
+    // Ideal half-band response sin(pi*x/2)/(pi*x), at the odd distances from the center
+    for (int x = 1; x <= center; x += 2)
+    {
+        const double h = std::sin(PI * x / 2.) / (PI * x);
+        fir.push_back(static_cast<short>(std::lround(32768. * h * SincResampler::kaiserWindow(static_cast<double>(x) / (center + 1)))));
+    }
+
+    // The output is ready with the last tap, half the filter length past the center one
+    groupDelay = center / inputFrequency;
+
+    reset();
+}
+
+namespace
+{
+
+/**
+ * The filter works on 16 bit samples, saturate the rare overshoots.
+ */
+inline short saturate(int x)
+{
+    return static_cast<short>(std::min(std::max(x, -32768), 32767));
+}
+
+}
+
+void HalfBandDecimator::filter(int index, int pairs, int* out) const
+{
+    // The filter spans 2*m+2 pairs
+    const int m = static_cast<int>(fir.size()) - 1;
+
+    // Mirrored positions, so looking back never goes below the start of the buffers
+    const short* center = first + RINGSIZE + index - m;
+    const short* taps = second + RINGSIZE + index - m;
+
+    for (int j = 0; j < pairs; j++)
+    {
+        out[j] = static_cast<int>(center[j]) << 14;
+    }
+
+    for (int i = 0; i <= m; i++)
+    {
+        const int h = fir[i];
+        const short* after = taps + i;
+        const short* before = taps - 1 - i;
+
+        for (int j = 0; j < pairs; j++)
+        {
+            out[j] += h * (after[j] + before[j]);
+        }
+    }
+
+    for (int j = 0; j < pairs; j++)
+    {
+        out[j] = (out[j] + (1 << 14)) >> 15;
+    }
+}
+
+bool HalfBandDecimator::input(int input)
+{
+    const short value = saturate(input);
+    constantRun = (value == lastInput) ? std::min(constantRun + 1, 4 * static_cast<int>(fir.size())) : 1;
+    lastInput = value;
+
+    if (!half)
+    {
+        first[pairIndex] = first[pairIndex + RINGSIZE] = value;
+        half = true;
+        return false;
+    }
+
+    second[pairIndex] = second[pairIndex + RINGSIZE] = value;
+    filter(pairIndex, 1, &outputValue);
+
+    pairIndex = (pairIndex + 1) & (RINGSIZE - 1);
+    half = false;
+    return true;
+}
+
+int HalfBandDecimator::process(const int* in, int n, int* out)
+{
+    int s = 0;
+
+    // Complete the pair left over from the previous block
+    if (half && n > 0)
+    {
+        input(*in++);
+        out[s++] = outputValue;
+        n--;
+    }
+
+    while (n >= 2)
+    {
+        // Store up to the end of the ring buffers at once
+        const int pairs = std::min(n / 2, RINGSIZE - pairIndex);
+
+        short* dstFirst = first + pairIndex;
+        short* dstSecond = second + pairIndex;
+        for (int j = 0; j < pairs; j++)
+        {
+            dstFirst[j] = saturate(in[2 * j]);
+            dstSecond[j] = saturate(in[2 * j + 1]);
+        }
+        std::memcpy(dstFirst + RINGSIZE, dstFirst, pairs * sizeof(short));
+        std::memcpy(dstSecond + RINGSIZE, dstSecond, pairs * sizeof(short));
+
+        // The input is all read before writing the output, which may overlap it
+        filter(pairIndex, pairs, out + s);
+        outputValue = out[s + pairs - 1];
+
+        s += pairs;
+        pairIndex = (pairIndex + pairs) & (RINGSIZE - 1);
+        in += 2 * pairs;
+        n -= 2 * pairs;
+    }
+
+    // The run of identical samples isn't tracked here
+    constantRun = 0;
+
+    if (n > 0)
+        input(*in);
+
+    return s;
+}
+
+int HalfBandDecimator::processConstant(int sample, int n, int* out)
+{
+    // The filter spans 2*m+2 pairs, from the second sample of the first one
+    const int span = 4 * static_cast<int>(fir.size());
+    const short value = saturate(sample);
+    int s = 0;
+
+    if (half && n > 0)
+    {
+        input(sample);
+        out[s++] = outputValue;
+        n--;
+    }
+
+    while (n >= 2)
+    {
+        const int pairs = std::min(n / 2, RINGSIZE - pairIndex);
+
+        std::fill_n(first + pairIndex, pairs, value);
+        std::fill_n(first + pairIndex + RINGSIZE, pairs, value);
+        std::fill_n(second + pairIndex, pairs, value);
+        std::fill_n(second + pairIndex + RINGSIZE, pairs, value);
+
+        if ((value == lastInput) && (constantRun >= span))
+        {
+            // The last output already saw nothing but this sample
+            std::fill_n(out + s, pairs, outputValue);
+        }
+        else
+        {
+            filter(pairIndex, pairs, out + s);
+            outputValue = out[s + pairs - 1];
+        }
+
+        constantRun = (value == lastInput) ? std::min(constantRun + 2 * pairs, span) : std::min(2 * pairs, span);
+        lastInput = value;
+
+        s += pairs;
+        pairIndex = (pairIndex + pairs) & (RINGSIZE - 1);
+        n -= 2 * pairs;
+    }
+
+    if (n > 0)
+        input(sample);
+
+    return s;
+}
+
+void HalfBandDecimator::reset()
+{
+    std::fill(std::begin(first), std::end(first), 0);
+    std::fill(std::begin(second), std::end(second), 0);
+    half = false;
+    outputValue = 0;
+    lastInput = 0;
+    constantRun = 0;
+}
+
+} // namespace reSIDfp
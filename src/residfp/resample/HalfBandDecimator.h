@@ -0,0 +1,171 @@
+/*
+ * This file is part of libsidplayfp, a SID player engine.
+ *
+ * Copyright 2011-2024 Leandro Nini <drfiemost@users.sourceforge.net>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+#ifndef HALFBANDDECIMATOR_H
+#define HALFBANDDECIMATOR_H
+
+#include "SincResampler.h"
+
+#include <vector>
+
+#include "sidcxx11.h"
+
+namespace reSIDfp
+{
+
+/**
+ * Decimation by two with a Kaiser windowed half-band filter.
+ *
+ * The filter only has to keep the passband free of aliases, so it can
+ * transition all the way from the passband to its mirror image
+ * around a quarter of the input rate. At high input rates this takes
+ * a handful of taps, and only about a quarter of them need a multiplication,
+ * which makes a chain of these a cheap way to bring the rate down
+ * before the final SINC.
+ *
+ * The input is split in pairs of samples: the first ones only contribute
+ * at the center of the filter, the second ones go through the nonzero taps,
+ * so the output for consecutive pairs vectorizes.
+ */
+class HalfBandDecimator
+{
+private:
+    /// Size of the ring buffers, must be a power of 2
+    static constexpr int RINGSIZE = 256;
+
+    /**
+     * Weight of a multiplication and fixed cost of an output sample,
+     * relative to the vectorized 16 bit multiply-accumulates of the SINC.
+     * Here the products are 32 bit and the samples have to be split in pairs.
+     */
+    static constexpr int TAP_WEIGHT = 8;
+    static constexpr int OUTPUT_OVERHEAD = 32;
+
+private:
+    /// Coefficients at the odd distances from the center, the filter is symmetric
+    /// and the ones at even distances are zero but for the center one, which is 1/2
+    std::vector<short> fir;
+
+    /// Position of the current pair of samples in the ring buffers
+    int pairIndex = 0;
+
+    /// Whether the first sample of the current pair is in
+    bool half = false;
+
+    int outputValue = 0;
+
+    /// Last input sample
+    short lastInput = 0;
+
+    /// Number of consecutive identical input samples, up to the filter span,
+    /// only counted by input() and processConstant()
+    int constantRun = 0;
+
+    /// Delay of the output, in seconds
+    double groupDelay;
+
+    /// First samples of the pairs, mirrored so the convolutions never wrap
+    short first[RINGSIZE * 2];
+
+    /// Second samples of the pairs, mirrored so the convolutions never wrap
+    short second[RINGSIZE * 2];
+
+private:
+    /**
+     * Filter the pairs of samples, the output for each pair is centered
+     * on the first sample of the pair half the filter length before.
+     *
+     * @param index position of the first pair in the ring buffers
+     * @param pairs number of pairs
+     * @param out output buffer
+     */
+    void filter(int index, int pairs, int* out) const;
+
+public:
+    /**
+     * @param inputFrequency input sampling rate
+     * @param highestAccurateFrequency passband frequency limit, must be below inputFrequency/4
+     */
+    HalfBandDecimator(double inputFrequency, double highestAccurateFrequency);
+
+    /**
+     * Length of the filter for the given rate.
+     *
+     * @param inputFrequency input sampling rate
+     * @param highestAccurateFrequency passband frequency limit
+     * @return number of taps
+     */
+    static int firLength(double inputFrequency, double highestAccurateFrequency);
+
+    /**
+     * Relative cost of an output sample for the given rate,
+     * in the same units as SincResampler::cost.
+     *
+     * @param inputFrequency input sampling rate
+     * @param highestAccurateFrequency passband frequency limit
+     * @return cost, infinite if the rate isn't supported
+     */
+    static double cost(double inputFrequency, double highestAccurateFrequency);
+
+    /**
+     * Input a sample.
+     *
+     * @param input input sample
+     * @return true when an output sample is ready
+     */
+    bool input(int input);
+
+    /**
+     * Input a block of samples, storing the output samples.
+     *
+     * @param in input samples
+     * @param n number of input samples
+     * @param out output buffer with room for (n + 1) / 2 samples, may be the same as in
+     * @return number of samples stored in out
+     */
+    int process(const int* in, int n, int* out);
+
+    /**
+     * Same as process() with n copies of the same sample.
+     * Once the filter only sees that sample, the output stays the same
+     * and there's nothing left to convolve.
+     *
+     * @param sample input sample
+     * @param n number of input samples
+     * @param out output buffer with room for (n + 1) / 2 samples
+     * @return number of samples stored in out
+     */
+    int processConstant(int sample, int n, int* out);
+
+    int output() const { return outputValue; }
+
+    /**
+     * Delay of the output relative to the input.
+     *
+     * @return the group delay in seconds
+     */
+    double delay() const { return groupDelay; }
+
+    void reset();
+};
+
+} // namespace reSIDfp
+
+#endif
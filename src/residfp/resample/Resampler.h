@@ -22,8 +22,10 @@
 #ifndef RESAMPLER_H
 #define RESAMPLER_H
 
+#include <algorithm>
 #include <cmath>
 #include <cassert>
+#include <cstdint>
 
 #include "sidcxx11.h"
 
@@ -71,13 +73,50 @@ protected:
      */
     static inline short softClip(int x) { return static_cast<short>(softClipImpl(x)); }
 
-    virtual int output() const = 0;
+    /*
+     * Scale and clip a resampled value.
+     */
+    static inline short scaleOutput(int value, int scaleFactor) { return softClip((scaleFactor * value) / 2); }
+
+    /// Size of the intermediate buffers used by process()
+    static constexpr int PROCESS_CHUNK = 256;
+
+    /**
+     * Adjust the number of cycles per sample for a ratio adjustment.
+     * The 1/1024 units alone are too coarse to follow a clock drift,
+     * so the rest goes in a 32 bit fraction of them.
+     * The output rate never goes past the input rate.
+     *
+     * @param base nominal cycles per sample, in 1/1024 units
+     * @param ppm output rate adjustment in parts per million
+     * @param cycles set to the adjusted cycles per sample, in 1/1024 units
+     * @param fraction set to the fraction of the 1/1024 units
+     */
+    static void adjustCyclesPerSample(double base, double ppm, int& cycles, std::uint32_t& fraction)
+    {
+        const double adjusted = std::max(base / (1. + ppm * 1e-6), 1024.);
+        const double whole = std::floor(adjusted);
+        cycles = static_cast<int>(whole);
+        fraction = static_cast<std::uint32_t>((adjusted - whole) * 4294967296.);
+    }
 
     Resampler() {}
 
 public:
     virtual ~Resampler() = default;
 
+    /**
+     * Last output sample, before scaling.
+     */
+    virtual int output() const = 0;
+
+    /**
+     * Delay of the output relative to the input, at low frequencies.
+     *
+     * @return the group delay in seconds
+     */
+    virtual double delay() const = 0;
+
     /**
      * Input a sample into resampler. Output "true" when resampler is ready with new sample.
      *
@@ -86,6 +125,45 @@ public:
      */
     virtual bool input(int sample) = 0;
 
+    /**
+     * Input a block of samples into resampler, storing the samples that get ready.
+     * Equivalent to calling input() for each sample followed by getOutput()
+     * when it returns true, but the filter is only evaluated at the output phases.
+     *
+     * @param in input samples
+     * @param n number of input samples
+     * @param out output buffer, with room for at least n samples
+     * @param scaleFactor output scaling, as for getOutput()
+     * @return number of samples stored in out
+     */
+    virtual int process(const int* in, int n, short* out, int scaleFactor) = 0;
+
+    /**
+     * Input a run of identical samples, storing the samples that get ready.
+     * Equivalent to process() with n copies of the sample.
+     *
+     * @param sample input sample
+     * @param n number of input samples
+     * @param out output buffer, with room for at least n samples
+     * @param scaleFactor output scaling, as for getOutput()
+     * @return number of samples stored in out
+     */
+    virtual int processConstant(int sample, int n, short* out, int scaleFactor)
+    {
+        int in[PROCESS_CHUNK];
+        std::fill_n(in, std::min(n, PROCESS_CHUNK), sample);
+
+        int s = 0;
+        while (n > 0)
+        {
+            const int len = std::min(n, PROCESS_CHUNK);
+            s += process(in, len, out + s, scaleFactor);
+            n -= len;
+        }
+
+        return s;
+    }
+
     /**
      * Output a sample from resampler.
      *
@@ -93,10 +171,17 @@ public:
      */
     inline short getOutput(int scaleFactor) const
     {
-        const int out = (scaleFactor * output()) / 2;
-        return softClip(out);
+        return scaleOutput(output(), scaleFactor);
     }
 
+    /**
+     * Nudge the output rate, to follow the clock of the audio device.
+     * The filters and the input history are kept.
+     *
+     * @param ppm output rate adjustment in parts per million, positive for more samples
+     */
+    virtual void setRatioAdjustment(double ppm) = 0;
+
     virtual void reset() = 0;
 };
 
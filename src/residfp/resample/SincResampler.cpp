@@ -31,9 +31,15 @@
 #  endif
 #endif
 #include <cassert>
+#include <complex>
 #include <cstring>
 #include <cmath>
 #include <cstdint>
+#include <limits>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <tuple>
 
 #include "siddefs-fp.h"
 
@@ -43,6 +49,18 @@
 #  include <numbers>
 #endif
 
+// Convolution versions for the vector extensions,
+// picked at runtime on x86 as they may not be available
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#  include <immintrin.h>
+#  define RESID_X86_DISPATCH
+#endif
+
+#if defined(__aarch64__) || (defined(__arm64__) && defined(__APPLE__))
+#  include <arm_neon.h>
+#  define RESID_NEON
+#endif
+
 
 #if __cpp_lib_constexpr_cmath >= 202306L
 #  define CONSTEXPR_FUNC  constexpr
@@ -55,11 +73,40 @@
 namespace reSIDfp
 {
 
+namespace
+{
+
 /// Maximum error acceptable in I0 is 1e-6, or ~96 dB.
 constexpr double I0E = 1e-6;
 
 constexpr int BITS = 16;
 
+#if defined(HAVE_CXX20) && defined(__cpp_lib_constexpr_cmath)
+constexpr double PI = std::numbers::pi;
+#else
+#  ifdef M_PI
+constexpr double PI = M_PI;
+#else
+constexpr double PI = 3.14159265358979323846;
+#  endif
+#endif
+
+/**
+ * 16 bits -> -96dB stopband attenuation.
+ */
+inline double stopbandAttenuation()
+{
+    return -20. * std::log10(1.0 / (1 << BITS));
+}
+
+/// FIR tables keyed by clock frequency, sampling frequency, passband, minimum phase and dense phases.
+/// The resamplers own the tables, so they are freed along with the last one using them.
+using fir_key_t = std::tuple<double, double, double, bool, bool>;
+using fir_cache_t = std::map<fir_key_t, std::weak_ptr<matrix_t>>;
+
+fir_cache_t FIR_CACHE;
+std::mutex FIR_CACHE_Lock;
+
 /**
  * Compute the 0th order modified Bessel function of the first kind.
  * This function is originally from resample-1.5/filterkit.c by J. O. Smith.
@@ -89,168 +136,425 @@ double I0(double x)
 }
 
 /**
- * Calculate convolution with sample and sinc.
+ * In place radix-2 FFT, the length must be a power of 2.
  *
- * @param a sample buffer input
- * @param b sinc buffer
- * @param bLength length of the sinc buffer
- * @return convolved result
+ * @param a the data to transform
+ * @param inverse whether to compute the inverse transform, scaled by 1/N
  */
-int convolve(const int* a, const short* b, int bLength)
+void fft(std::vector<std::complex<double>>& a, bool inverse)
 {
-#if defined(__has_cpp_attribute) && __has_cpp_attribute( assume )
-    [[assume( bLength > 0 )]];
-#endif
-#ifdef HAVE_SMMINTRIN_H
-    int out = 0;
+    const std::size_t n = a.size();
 
-    const uintptr_t offset = (uintptr_t)(b) & 0x0f;
+    for (std::size_t i = 1, j = 0; i < n; i++)
+    {
+        std::size_t bit = n >> 1;
+        for (; j & bit; bit >>= 1)
+            j ^= bit;
+        j ^= bit;
 
-    // check for aligned accesses
-    if (offset)
+        if (i < j)
+            std::swap(a[i], a[j]);
+    }
+
+    for (std::size_t len = 2; len <= n; len <<= 1)
     {
-        const int l = (0x10 - offset) / 2;
+        const double angle = (inverse ? 2. : -2.) * PI / len;
+        const std::complex<double> wlen(std::cos(angle), std::sin(angle));
 
-        for (int i = 0; i < l; i++)
+        for (std::size_t i = 0; i < n; i += len)
         {
-            out += a[i] * static_cast<int>(b[i]);
+            std::complex<double> w(1.);
+            for (std::size_t j = 0; j < len / 2; j++)
+            {
+                const std::complex<double> u = a[i + j];
+                const std::complex<double> v = a[i + j + len / 2] * w;
+                a[i + j] = u + v;
+                a[i + j + len / 2] = u - v;
+                w *= wlen;
+            }
         }
+    }
 
-        a += l;
-        b += l;
-        bLength -= l;
+    if (inverse)
+    {
+        for (auto& x : a)
+            x /= static_cast<double>(n);
     }
+}
 
-    __m128i acc = _mm_setzero_si128();
+/**
+ * Minimum phase filter with the same magnitude response as the given one,
+ * obtained by folding its real cepstrum onto the positive quefrencies.
+ *
+ * @param h the impulse response of the filter
+ * @return the minimum phase impulse response, with the same length
+ */
+std::vector<double> minimumPhaseResponse(const std::vector<double>& h)
+{
+    // Zero padding keeps the aliasing of the cepstrum low,
+    // with less of it the stopband falls a few dB short of the linear phase one
+    std::size_t n = 1;
+    while (n < 8 * h.size())
+        n <<= 1;
+
+    std::vector<std::complex<double>> a(n);
+    std::copy(h.begin(), h.end(), a.begin());
+    fft(a, false);
+
+    // Floor the zeros of the stopband at -112 dB, well below the 16 bit attenuation,
+    // the deeper notches would only add to the aliasing of the cepstrum
+    double peak = 0.;
+    for (const auto& x : a)
+        peak = std::max(peak, std::abs(x));
+    const double floor = peak * 2.5e-6;
+
+    for (auto& x : a)
+        x = std::log(std::max(std::abs(x), floor));
+    fft(a, true);
+
+    // Keep the causal part of the cepstrum
+    for (std::size_t i = 1; i < n / 2; i++)
+        a[i] *= 2.;
+    for (std::size_t i = n / 2 + 1; i < n; i++)
+        a[i] = 0.;
+
+    fft(a, false);
+    for (auto& x : a)
+        x = std::exp(x);
+    fft(a, true);
+
+    std::vector<double> result(h.size());
+    for (std::size_t i = 0; i < h.size(); i++)
+        result[i] = a[i].real();
+
+    return result;
+}
 
-    const int n = bLength / 8;
+/**
+ * Round the convolution sum back to 16 bit.
+ */
+inline int roundSum(int64_t out)
+{
+    return static_cast<int>((out + (1 << 14)) >> 15);
+}
 
+/**
+ * Sum the 32 bit lanes of the vector accumulators.
+ * Each lane only holds a fraction of the taps and stays in range,
+ * but with full scale input the whole sum can exceed 32 bit.
+ *
+ * @param lanes the lanes
+ * @param n number of lanes
+ * @return the sum of the lanes
+ */
+inline int64_t sumLanes(const int* lanes, int n)
+{
+    int64_t out = 0;
     for (int i = 0; i < n; i++)
     {
-        const __m128i tmp_b = _mm_stream_load_si128((__m128i*)b);
+        out += lanes[i];
+    }
+    return out;
+}
+
+/**
+ * Calculate convolution with sample and sinc.
+ * Plain C++ version, also used for the tail of the vector versions.
+ *
+ * @param a sample buffer input
+ * @param b sinc buffer
+ * @param bLength length of the sinc buffer
+ * @param out sum of the preceding products
+ * @return convolution sum
+ */
+inline int64_t convolveTail(const short* a, const short* b, int bLength, int64_t out)
+{
+#ifndef __clang__
+    return std::inner_product(a, a+bLength, b, out);
+#else
+    // Apparently clang is unable to fully optimize the above
+    // feed it some plain ol' c code
+    for (int i=0; i<bLength; i++)
+    {
+        out += static_cast<int>(a[i]) * static_cast<int>(b[i]);
+    }
+    return out;
+#endif
+}
+
+/**
+ * Calculate convolution with sample and sinc.
+ *
+ * @param a sample buffer input
+ * @param b sinc buffer
+ * @param bLength length of the sinc buffer
+ * @return convolved result
+ */
+int convolveScalar(const short* a, const short* b, int bLength)
+{
+    return roundSum(convolveTail(a, b, bLength, 0));
+}
 
-        __m128i val_b = _mm_cvtepi16_epi32(tmp_b);
-        __m128i prod = _mm_mullo_epi32(*(__m128i*)a, val_b);
-        acc = _mm_add_epi32(acc, prod);
-        a += 4;
+#ifdef RESID_X86_DISPATCH
 
-        val_b = _mm_cvtepi16_epi32(_mm_srli_si128(tmp_b, 8));
-        prod = _mm_mullo_epi32(*(__m128i*)a, val_b);
-        acc = _mm_add_epi32(acc, prod);
-        a += 4;
+// Samples and coefficients are both 16 bit so pmaddwd multiplies
+// and sums pairs of them straight into 32 bit lanes.
+// The lanes are summed in 64 bit, like the plain C++ version,
+// so all the versions give the same result.
+
+__attribute__((target("sse2")))
+int convolveSSE2(const short* a, const short* b, int bLength)
+{
+    __m128i acc = _mm_setzero_si128();
+
+    const int n = bLength / 8;
+
+    for (int i = 0; i < n; i++)
+    {
+        const __m128i val_a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(a));
+        const __m128i val_b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(b));
+        acc = _mm_add_epi32(acc, _mm_madd_epi16(val_a, val_b));
 
+        a += 8;
         b += 8;
     }
 
-    __m128i vsum = _mm_add_epi32(acc, _mm_srli_si128(acc, 8));
-    vsum = _mm_add_epi32(vsum, _mm_srli_si128(vsum, 4));
-    out += _mm_cvtsi128_si32(vsum);
+    alignas(16) int lanes[4];
+    _mm_store_si128(reinterpret_cast<__m128i*>(lanes), acc);
 
-    bLength &= 7;
+    return roundSum(convolveTail(a, b, bLength & 7, sumLanes(lanes, 4)));
+}
 
-/*#elif defined(HAVE_ARM_NEON_H)
-#if (defined(__arm64__) && defined(__APPLE__)) || defined(__aarch64__)
-    int32x4_t acc1Low = vdupq_n_s32(0);
-    int32x4_t acc1High = vdupq_n_s32(0);
-    int32x4_t acc2Low = vdupq_n_s32(0);
-    int32x4_t acc2High = vdupq_n_s32(0);
+__attribute__((target("avx2")))
+int convolveAVX2(const short* a, const short* b, int bLength)
+{
+    __m256i acc1 = _mm256_setzero_si256();
+    __m256i acc2 = _mm256_setzero_si256();
 
-    const int n = bLength / 16;
+    const int n = bLength / 32;
 
     for (int i = 0; i < n; i++)
     {
-        int16x8_t v11 = vld1q_s16(a);
-        int16x8_t v12 = vld1q_s16(a + 8);
-        int16x8_t v21 = vld1q_s16(b);
-        int16x8_t v22 = vld1q_s16(b + 8);
+        const __m256i val_a1 = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(a));
+        const __m256i val_a2 = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(a + 16));
+        const __m256i val_b1 = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(b));
+        const __m256i val_b2 = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(b + 16));
 
-        acc1Low  = vmlal_s16(acc1Low, vget_low_s16(v11), vget_low_s16(v21));
-        acc1High = vmlal_high_s16(acc1High, v11, v21);
-        acc2Low  = vmlal_s16(acc2Low, vget_low_s16(v12), vget_low_s16(v22));
-        acc2High = vmlal_high_s16(acc2High, v12, v22);
+        acc1 = _mm256_add_epi32(acc1, _mm256_madd_epi16(val_a1, val_b1));
+        acc2 = _mm256_add_epi32(acc2, _mm256_madd_epi16(val_a2, val_b2));
+
+        a += 32;
+        b += 32;
+    }
+
+    if (bLength & 16)
+    {
+        const __m256i val_a = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(a));
+        const __m256i val_b = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(b));
+        acc1 = _mm256_add_epi32(acc1, _mm256_madd_epi16(val_a, val_b));
 
         a += 16;
         b += 16;
     }
 
-    bLength &= 15;
+    alignas(32) int lanes[16];
+    _mm256_store_si256(reinterpret_cast<__m256i*>(lanes), acc1);
+    _mm256_store_si256(reinterpret_cast<__m256i*>(lanes + 8), acc2);
+
+    return roundSum(convolveTail(a, b, bLength & 15, sumLanes(lanes, 16)));
+}
+
+/**
+ * Horizontal sum of the 32 bit lanes, in 64 bit.
+ */
+__attribute__((target("avx512f")))
+int64_t sumAVX512(__m512i acc)
+{
+    alignas(64) int lanes[16];
+    _mm512_store_si512(lanes, acc);
+    return sumLanes(lanes, 16);
+}
+
+__attribute__((target("avx512f,avx512bw")))
+int convolveAVX512(const short* a, const short* b, int bLength)
+{
+    __m512i acc = _mm512_setzero_si512();
+
+    const int n = bLength / 32;
 
-    if (bLength >= 8)
+    for (int i = 0; i < n; i++)
     {
-        int16x8_t v1 = vld1q_s16(a);
-        int16x8_t v2 = vld1q_s16(b);
+        const __m512i val_a = _mm512_loadu_si512(a);
+        const __m512i val_b = _mm512_loadu_si512(b);
+        acc = _mm512_add_epi32(acc, _mm512_madd_epi16(val_a, val_b));
 
-        acc1Low  = vmlal_s16(acc1Low, vget_low_s16(v1), vget_low_s16(v2));
-        acc1High = vmlal_high_s16(acc1High, v1, v2);
+        a += 32;
+        b += 32;
+    }
 
-        a += 8;
-        b += 8;
+    // The remaining taps with a masked load
+    const int l = bLength & 31;
+    if (l > 0)
+    {
+        const __mmask32 mask = static_cast<__mmask32>((1u << l) - 1);
+        const __m512i val_a = _mm512_maskz_loadu_epi16(mask, a);
+        const __m512i val_b = _mm512_maskz_loadu_epi16(mask, b);
+        acc = _mm512_add_epi32(acc, _mm512_madd_epi16(val_a, val_b));
     }
 
-    bLength &= 7;
+    return roundSum(sumAVX512(acc));
+}
+
+/**
+ * Same as above with the multiply and the accumulate fused into vpdpwssd.
+ */
+__attribute__((target("avx512f,avx512bw,avx512vnni")))
+int convolveAVX512VNNI(const short* a, const short* b, int bLength)
+{
+    __m512i acc = _mm512_setzero_si512();
+
+    const int n = bLength / 32;
 
-    if (bLength >= 4)
+    for (int i = 0; i < n; i++)
     {
-        int16x4_t v1 = vld1_s16(a);
-        int16x4_t v2 = vld1_s16(b);
+        acc = _mm512_dpwssd_epi32(acc, _mm512_loadu_si512(a), _mm512_loadu_si512(b));
 
-        acc1Low  = vmlal_s16(acc1Low, v1, v2);
+        a += 32;
+        b += 32;
+    }
 
-        a += 4;
-        b += 4;
+    const int l = bLength & 31;
+    if (l > 0)
+    {
+        const __mmask32 mask = static_cast<__mmask32>((1u << l) - 1);
+        acc = _mm512_dpwssd_epi32(acc, _mm512_maskz_loadu_epi16(mask, a), _mm512_maskz_loadu_epi16(mask, b));
     }
 
-    int32x4_t accSumsNeon = vaddq_s32(acc1Low, acc1High);
-    accSumsNeon = vaddq_s32(accSumsNeon, acc2Low);
-    accSumsNeon = vaddq_s32(accSumsNeon, acc2High);
+    return roundSum(sumAVX512(acc));
+}
+
+#endif
 
-    int out = vaddvq_s32(accSumsNeon);
+#ifdef RESID_NEON
 
-    bLength &= 3;
-#else
-    int32x4_t acc = vdupq_n_s32(0);
+int convolveNEON(const short* a, const short* b, int bLength)
+{
+    int32x4_t acc1 = vdupq_n_s32(0);
+    int32x4_t acc2 = vdupq_n_s32(0);
 
-    const int n = bLength / 4;
+    const int n = bLength / 8;
 
     for (int i = 0; i < n; i++)
     {
-        const int16x4_t h_vec = vld1_s16(a);
-        const int16x4_t x_vec = vld1_s16(b);
-        acc = vmlal_s16(acc, h_vec, x_vec);
-        a += 4;
-        b += 4;
+        const int16x8_t val_a = vld1q_s16(a);
+        const int16x8_t val_b = vld1q_s16(b);
+
+        acc1 = vmlal_s16(acc1, vget_low_s16(val_a), vget_low_s16(val_b));
+        acc2 = vmlal_high_s16(acc2, val_a, val_b);
+
+        a += 8;
+        b += 8;
     }
 
-    int out = vgetq_lane_s32(acc, 0) +
-              vgetq_lane_s32(acc, 1) +
-              vgetq_lane_s32(acc, 2) +
-              vgetq_lane_s32(acc, 3);
+    // Widening sums of the lanes
+    const int64_t out = vaddlvq_s32(acc1) + vaddlvq_s32(acc2);
+
+    return roundSum(convolveTail(a, b, bLength & 7, out));
+}
 
-    bLength &= 3;
-#endif*/
-#else
-    int out = 0;
 #endif
-#ifndef __clang__
-    out = std::inner_product(a, a+bLength, b, out);
-#else
-    // Apparently clang is unable to fully optimize the above
-    // feed it some plain ol' c code
-    for (int i=0; i<bLength; i++)
+
+/**
+ * Pick the fastest convolution the CPU supports.
+ */
+SincResampler::convolve_t selectConvolve()
+{
+#ifdef RESID_X86_DISPATCH
+    __builtin_cpu_init();
+
+    if (__builtin_cpu_supports("avx512bw"))
     {
-        out += a[i] * static_cast<int>(b[i]);
+        return __builtin_cpu_supports("avx512vnni")
+            ? convolveAVX512VNNI : convolveAVX512;
     }
+    if (__builtin_cpu_supports("avx2"))
+        return convolveAVX2;
+    if (__builtin_cpu_supports("sse2"))
+        return convolveSSE2;
+#endif
+
+#ifdef RESID_NEON
+    // NEON is part of the AArch64 baseline
+    return convolveNEON;
+#else
+    return convolveScalar;
 #endif
+}
 
-    return (out + (1 << 14)) >> 15;
+}
+
+std::vector<SincResampler::convolve_t> SincResampler::convolutions()
+{
+    std::vector<convolve_t> result { convolveScalar };
+
+#ifdef RESID_X86_DISPATCH
+    __builtin_cpu_init();
+
+    if (__builtin_cpu_supports("sse2"))
+        result.push_back(convolveSSE2);
+    if (__builtin_cpu_supports("avx2"))
+        result.push_back(convolveAVX2);
+    if (__builtin_cpu_supports("avx512bw"))
+        result.push_back(convolveAVX512);
+    if (__builtin_cpu_supports("avx512bw") && __builtin_cpu_supports("avx512vnni"))
+        result.push_back(convolveAVX512VNNI);
+#endif
+
+#ifdef RESID_NEON
+    result.push_back(convolveNEON);
+#endif
+
+    return result;
 }
 
 int SincResampler::fir(int subcycle)
 {
+    if (densePhases)
+    {
+        // The nearest fir table is close enough to the phase,
+        // wrap around to the first one using the previous sample
+        int firTable0 = (subcycle * firRES + 512) >> 10;
+        int sampleStart = sampleIndex - firN + RINGSIZE - 1;
+        if (unlikely(firTable0 == firRES))
+        {
+            firTable0 = 0;
+            ++sampleStart;
+        }
+
+        if (constantRun > firN)
+        {
+            return static_cast<int>((static_cast<int64_t>(lastInput) * firSum[firTable0] + (1 << 14)) >> 15);
+        }
+
+        return convolve(sample + sampleStart, (*firTable)[firTable0], firN);
+    }
+
     // Find the first of the nearest fir tables close to the phase
     int firTableFirst = (subcycle * firRES >> 10);
     const int firTableOffset = (subcycle * firRES) & 0x3ff;
 
+    // When the firN + 1 most recent samples are the same the convolutions
+    // reduce to a product with the sum of the coefficients.
+    if (constantRun > firN)
+    {
+        const int v1 = static_cast<int>((static_cast<int64_t>(lastInput) * firSum[firTableFirst] + (1 << 14)) >> 15);
+        if (unlikely(++firTableFirst == firRES))
+            firTableFirst = 0;
+        const int v2 = static_cast<int>((static_cast<int64_t>(lastInput) * firSum[firTableFirst] + (1 << 14)) >> 15);
+
+        return v1 + (firTableOffset * (v2 - v1) >> 10);
+    }
+
     // Find firN most recent samples, plus one extra in case the FIR wraps.
     int sampleStart = sampleIndex - firN + RINGSIZE - 1;
 
@@ -271,49 +575,106 @@ int SincResampler::fir(int subcycle)
     return v1 + (firTableOffset * (v2 - v1) >> 10);
 }
 
-SincResampler::SincResampler(
+int SincResampler::firFixed() const
+{
+    // The phase falls right on its table, there's nothing to interpolate
+    const int firTable0 = phase * (firRES / phaseCount);
+
+    if (constantRun > firN)
+    {
+        return static_cast<int>((static_cast<int64_t>(lastInput) * firSum[firTable0] + (1 << 14)) >> 15);
+    }
+
+    return convolve(sample + sampleIndex - firN + RINGSIZE - 1, (*firTable)[firTable0], firN);
+}
+
+int SincResampler::kaiserOrder(double dw)
+{
+    // For calculation of N see the reference for the kaiserord
+    // function in the MATLAB Signal Processing Toolbox:
+    // http://www.mathworks.com/help/signal/ref/kaiserord.html
+    return static_cast<int>((stopbandAttenuation() - 7.95) / (2.285 * dw) + 0.5);
+}
+
+double SincResampler::kaiserWindow(double xt)
+{
+    const double A = stopbandAttenuation();
+    const double beta = 0.1102 * (A - 8.7);
+    static const double I0beta = I0(beta);
+
+    return std::fabs(xt) < 1. ? I0(beta * std::sqrt(1. - xt * xt)) / I0beta : 0.;
+}
+
+int SincResampler::firLength(
         double clockFrequency,
         double samplingFrequency,
-        double highestAccurateFrequency) :
-    cyclesPerSample(static_cast<int>(clockFrequency / samplingFrequency * 1024.))
+        double highestAccurateFrequency)
 {
-#if defined(HAVE_CXX20) && defined(__cpp_lib_constexpr_cmath)
-    constexpr double PI = std::numbers::pi;
-#else
-#  ifdef M_PI
-        constexpr double PI = M_PI;
-#else
-        constexpr double PI = 3.14159265358979323846;
-#  endif
-#endif
-
-    // 16 bits -> -96dB stopband attenuation.
-    const double A = -20. * std::log10(1.0 / (1 << BITS));
     // A fraction of the bandwidth is allocated to the transition band, which we double
     // because we design the filter to transition halfway at nyquist.
     const double dw = (1. - 2.*highestAccurateFrequency / samplingFrequency) * PI * 2.;
 
-    // For calculation of beta and N see the reference for the kaiserord
-    // function in the MATLAB Signal Processing Toolbox:
-    // http://www.mathworks.com/help/signal/ref/kaiserord.html
-    const double beta = 0.1102 * (A - 8.7);
-    const double I0beta = I0(beta);
-    const double cyclesPerSampleD = clockFrequency / samplingFrequency;
-    const double inv_cyclesPerSampleD = samplingFrequency / clockFrequency;
+    // The filter order will maximally be 124 with the current constraints.
+    // N >= (96.33 - 7.95)/(2 * pi * 2.285 * (maxfreq - passbandfreq) >= 123
+    // The filter order is equal to the number of zero crossings, i.e.
+    // it should be an even number (sinc is symmetric with respect to x = 0).
+    int N = kaiserOrder(dw);
+    N += N & 1;
+
+    // The filter length is equal to the filter order + 1.
+    // The filter length must be an odd number (sinc is symmetric with respect to
+    // x = 0).
+    const int firN = static_cast<int>(N * (clockFrequency / samplingFrequency)) + 1;
+    return firN | 1;
+}
+
+int SincResampler::rationalPhases(double clockFrequency, double samplingFrequency)
+{
+    const double ratio = clockFrequency / samplingFrequency;
 
+    // Smallest denominator that makes the ratio a whole number,
+    // give or take the rounding of the rates
+    for (int q = 1; q <= MAX_RATIONAL_PHASES; q++)
     {
-        // The filter order will maximally be 124 with the current constraints.
-        // N >= (96.33 - 7.95)/(2 * pi * 2.285 * (maxfreq - passbandfreq) >= 123
-        // The filter order is equal to the number of zero crossings, i.e.
-        // it should be an even number (sinc is symmetric with respect to x = 0).
-        int N = static_cast<int>((A - 7.95) / (2.285 * dw) + 0.5);
-        N += N & 1;
+        const double p = ratio * q;
+        if (std::fabs(p - std::round(p)) <= p * 1e-9)
+            return q;
+    }
+
+    return 0;
+}
+
+double SincResampler::cost(
+        double clockFrequency,
+        double samplingFrequency,
+        double highestAccurateFrequency)
+{
+    const int firN = firLength(clockFrequency, samplingFrequency, highestAccurateFrequency);
+
+    // Two convolutions per output sample, or one with a rational ratio,
+    // unless the ring buffer can't hold the filter.
+    // Picking the phase, interpolating and storing the result weighs about
+    // as much as a few hundred vectorized multiply-accumulates.
+    return (firN < RINGSIZE)
+        ? ((rationalPhases(clockFrequency, samplingFrequency) > 0) ? 1. : 2.) * firN + OUTPUT_OVERHEAD
+        : std::numeric_limits<double>::infinity();
+}
+
+SincResampler::SincResampler(
+        double clockFrequency,
+        double samplingFrequency,
+        double highestAccurateFrequency,
+        bool minimumPhase,
+        bool densePhases) :
+    convolve(selectConvolve()),
+    densePhases(densePhases),
+    baseCyclesPerSample(static_cast<int>(clockFrequency / samplingFrequency * 1024.)),
+    cyclesPerSample(baseCyclesPerSample)
+{
+    const double inv_cyclesPerSampleD = samplingFrequency / clockFrequency;
 
-        // The filter length is equal to the filter order + 1.
-        // The filter length must be an odd number (sinc is symmetric with respect to
-        // x = 0).
-        firN = static_cast<int>(N * cyclesPerSampleD) + 1;
-        firN |= 1;
+    {
+        firN = firLength(clockFrequency, samplingFrequency, highestAccurateFrequency);
 
         // Check whether the sample ring buffer would overflow.
         assert(firN < RINGSIZE);
@@ -326,58 +687,275 @@ SincResampler::SincResampler(
         // The filter test program indicates that the filter performs well, though.
     }
 
+    // Resolution of the tables for the linear interpolation
+    const int interpolatedRES = firRES;
+
+    if (densePhases)
+    {
+        // Without the interpolation the nearest table is up to half a step away.
+        // The steepest slope of the sinc is about 0.436*pi*r per sample, r being
+        // the ratio of the rates, and the tables are scaled by 32768*r,
+        // so the error stays below half a unit with 32768*1.37*r^2 tables.
+        // The phase only has 1/1024 sample steps, so with 1024 tables
+        // each one falls right on its table and more would never be used.
+        const double r = inv_cyclesPerSampleD;
+        firRES = std::max(firRES, std::min(static_cast<int>(std::ceil(32768. * 1.37 * r * r)), 1024));
+    }
+
+    phaseCount = rationalPhases(clockFrequency, samplingFrequency);
+    if (phaseCount > 0)
+    {
+        // Each phase of the ratio gets a table of its own
+        firRES = (firRES + phaseCount - 1) / phaseCount * phaseCount;
+
+        // Precompute the sequence of the phases
+        phaseStep = static_cast<int>(std::lround(clockFrequency / samplingFrequency * phaseCount));
+        phaseAdvance.resize(phaseCount);
+        nextPhase.resize(phaseCount);
+        for (int o = 0; o < phaseCount; o++)
+        {
+            phaseAdvance[o] = (o + phaseStep) / phaseCount;
+            nextPhase[o] = (o + phaseStep) % phaseCount;
+        }
+        fixedPhases = true;
+    }
+
     {
-        // Allocate memory for FIR tables.
-        firTable = new matrix_t(firRES, firN);
+        // The tables only depend on the rate parameters,
+        // so resamplers set up the same way share them.
+        const fir_key_t firKey(clockFrequency, samplingFrequency, highestAccurateFrequency, minimumPhase, densePhases);
+
+        std::lock_guard<std::mutex> lock(FIR_CACHE_Lock);
+
+        // Forget the tables no resampler uses anymore,
+        // the ratio adjustment can go through many rates
+        for (fir_cache_t::iterator it = FIR_CACHE.begin(); it != FIR_CACHE.end();)
+        {
+            if (it->second.expired())
+                it = FIR_CACHE.erase(it);
+            else
+                ++it;
+        }
+
+        std::weak_ptr<matrix_t>& cached = FIR_CACHE[firKey];
+        firTable = cached.lock();
+
+        if (!firTable)
+        {
+            matrix_t tempTable(firRES, firN);
+
+            // The cutoff frequency is midway through the transition band, in effect the same as nyquist.
+            constexpr double wc = PI;
+
+            // Calculate the sinc tables.
+            const double scale = 32768.0 * wc * inv_cyclesPerSampleD / PI;
 
-        // The cutoff frequency is midway through the transition band, in effect the same as nyquist.
-        constexpr double wc = PI;
+            // we're not interested in the fractional part
+            // so use int division before converting to double
+            const int tmp = firN / 2;
+            const double firN_2 = static_cast<double>(tmp);
 
-        // Calculate the sinc tables.
-        const double scale = 32768.0 * wc * inv_cyclesPerSampleD / PI;
+            if (!minimumPhase)
+            {
+                for (int i = 0; i < firRES; i++)
+                {
+                    const double jPhase = (double) i / firRES + firN_2;
+
+                    for (int j = 0; j < firN; j++)
+                    {
+                        const double x = j - jPhase;
+
+                        const double kaiserXt = kaiserWindow(x / firN_2);
 
-        // we're not interested in the fractional part
-        // so use int division before converting to double
-        const int tmp = firN / 2;
-        const double firN_2 = static_cast<double>(tmp);
+                        const double wt = wc * x * inv_cyclesPerSampleD;
+                        const double sincWt = std::fabs(wt) >= 1e-8 ? std::sin(wt) / wt : 1.;
 
+                        tempTable[i][j] = static_cast<short>(scale * sincWt * kaiserXt);
+                    }
+                }
+            }
+            else
+            {
+                // Sample the same filter at the resolution of all the interpolated tables together,
+                // the transform would get too large for the dense ones
+                const int length = firN * interpolatedRES;
+                std::vector<double> prototype(length);
+
+                for (int k = 0; k < length; k++)
+                {
+                    const double x = static_cast<double>(k) / interpolatedRES - firN_2;
+
+                    const double kaiserXt = kaiserWindow(x / firN_2);
+
+                    const double wt = wc * x * inv_cyclesPerSampleD;
+                    const double sincWt = std::fabs(wt) >= 1e-8 ? std::sin(wt) / wt : 1.;
+
+                    prototype[k] = sincWt * kaiserXt;
+                }
+
+                const std::vector<double> h = minimumPhaseResponse(prototype);
+
+                // The response starts at the newest sample, the last one of the tables.
+                // Dense tables fall between the samples of the response, interpolate.
+                for (int i = 0; i < firRES; i++)
+                {
+                    for (int j = 0; j < firN; j++)
+                    {
+                        const double k = static_cast<double>((firN - 1 - j) * firRES + i) * interpolatedRES / firRES;
+                        const int k0 = static_cast<int>(k);
+                        const double h1 = (k0 + 1 < length) ? h[k0 + 1] : 0.;
+                        const double value = scale * (h[k0] + (k - k0) * (h1 - h[k0]));
+                        // Round to nearest, truncating the lopsided response
+                        // leaves a bias that raises the stopband floor
+                        tempTable[i][j] = static_cast<short>(std::lround(std::min(std::max(value, -32768.), 32767.)));
+                    }
+                }
+            }
+
+            firTable = std::make_shared<matrix_t>(tempTable);
+            cached = firTable;
+        }
+    }
+
+    {
+        firSum.resize(firRES);
         for (int i = 0; i < firRES; i++)
         {
-            const double jPhase = (double) i / firRES + firN_2;
+            const short* fir = (*firTable)[i];
+            firSum[i] = std::accumulate(fir, fir + firN, 0);
+        }
 
+        // Group delay from the centroid of the filters, averaged over the phases.
+        // The last tap meets the sample before the newest one.
+        double moment = 0.;
+        double total = 0.;
+        for (int i = 0; i < firRES; i++)
+        {
+            const short* fir = (*firTable)[i];
             for (int j = 0; j < firN; j++)
             {
-                const double x = j - jPhase;
+                moment += static_cast<double>(firN - j) * fir[j];
+            }
+            total += firSum[i];
+        }
+        groupDelay = moment / total / clockFrequency;
+    }
 
-                const double xt = x / firN_2;
-                const double kaiserXt = std::fabs(xt) < 1. ? I0(beta * std::sqrt(1. - xt * xt)) / I0beta : 0.;
+    // Start from silence, not from whatever was in memory before
+    reset();
+}
 
-                const double wt = wc * x * inv_cyclesPerSampleD;
-                const double sincWt = std::fabs(wt) >= 1e-8 ? std::sin(wt) / wt : 1.;
+SincResampler::~SincResampler() = default;
 
-                (*firTable)[i][j] = static_cast<short>(scale * sincWt * kaiserXt);
-            }
+namespace
+{
+
+/**
+ * The convolutions work on 16 bit samples, saturate the rare
+ * overshoots of the external filter and of the first resampling pass.
+ */
+inline short saturate(int x)
+{
+#ifdef HAVE_CXX17
+    return static_cast<short>(std::clamp(x, -32768, 32767));
+#else
+    return static_cast<short>(std::min(std::max(x, -32768), 32767));
+#endif
+}
+
+}
+
+void SincResampler::ingest(const int* in, int n)
+{
+    // Length of the run of identical samples at the end of the block,
+    // there's no need to count past firN + 1
+    const int last = saturate(in[n - 1]);
+    int run = 1;
+    while (run < n && run <= firN && saturate(in[n - 1 - run]) == last)
+    {
+        run++;
+    }
+
+    if (run == n && last == lastInput)
+    {
+        constantRun = std::min(constantRun + n, firN + 1);
+    }
+    else
+    {
+        constantRun = run;
+    }
+    lastInput = last;
+
+    while (n > 0)
+    {
+        const int len = std::min(n, RINGSIZE - sampleIndex);
+
+        short* dst = sample + sampleIndex;
+        for (int i = 0; i < len; i++)
+        {
+            dst[i] = saturate(in[i]);
         }
+        std::memcpy(dst + RINGSIZE, dst, len * sizeof(short));
+
+        sampleIndex = (sampleIndex + len) & (RINGSIZE - 1);
+        in += len;
+        n -= len;
+    }
+}
+
+void SincResampler::ingest(ConstantInput in, int n)
+{
+    const short value = saturate(in.value);
+
+    constantRun = (value == lastInput) ? std::min(constantRun + n, firN + 1) : std::min(n, firN + 1);
+    lastInput = value;
+
+    // The convolutions only read back the firN + 1 most recent samples
+    const int stored = std::min(n, firN + 1);
+    sampleIndex = (sampleIndex + n - stored) & (RINGSIZE - 1);
+
+    for (int left = stored; left > 0; )
+    {
+        const int len = std::min(left, RINGSIZE - sampleIndex);
+
+        std::fill_n(sample + sampleIndex, len, value);
+        std::fill_n(sample + sampleIndex + RINGSIZE, len, value);
+
+        sampleIndex = (sampleIndex + len) & (RINGSIZE - 1);
+        left -= len;
     }
 }
 
-SincResampler::~SincResampler()
+inline void SincResampler::advance()
 {
-    delete firTable;
+    sampleOffset += cyclesPerSample;
+    sampleOffsetFraction += cyclesPerSampleFraction;
+    if (sampleOffsetFraction < cyclesPerSampleFraction)
+        sampleOffset++;
 }
 
 bool SincResampler::input(int input)
 {
     bool ready = false;
 
-    sample[sampleIndex] = sample[sampleIndex + RINGSIZE] = input;
-    sampleIndex = (sampleIndex + 1) & (RINGSIZE - 1);
+    ingest(&input, 1);
+
+    if (fixedPhases)
+    {
+        if (--pending > 0)
+            return false;
+
+        outputValue = firFixed();
+        pending = phaseAdvance[phase];
+        phase = nextPhase[phase];
+        return true;
+    }
 
     if (sampleOffset < 1024)
     {
         outputValue = fir(sampleOffset);
         ready = true;
-        sampleOffset += cyclesPerSample;
+        advance();
     }
 
     sampleOffset -= 1024;
@@ -385,10 +963,155 @@ bool SincResampler::input(int input)
     return ready;
 }
 
+template<typename Input>
+int SincResampler::resampleFixed(Input in, int n, int* out)
+{
+    int s = 0;
+
+    while (n >= pending)
+    {
+        ingest(in, pending);
+        in += pending;
+        n -= pending;
+
+        outputValue = firFixed();
+        out[s++] = outputValue;
+
+        pending = phaseAdvance[phase];
+        phase = nextPhase[phase];
+    }
+
+    if (n > 0)
+    {
+        ingest(in, n);
+        pending -= n;
+    }
+
+    return s;
+}
+
+template<typename Input>
+int SincResampler::resampleInput(Input in, int n, int* out)
+{
+    if (fixedPhases)
+        return resampleFixed(in, n, out);
+
+    int s = 0;
+    int i = 0;
+
+    for (;;)
+    {
+        // Number of samples to skip until the next output is due
+        const int skip = sampleOffset >> 10;
+
+        if (i + skip >= n)
+        {
+            if (i < n)
+                ingest(in + i, n - i);
+            sampleOffset -= (n - i) << 10;
+            return s;
+        }
+
+        ingest(in + i, skip + 1);
+        i += skip + 1;
+        sampleOffset -= skip << 10;
+
+        outputValue = fir(sampleOffset);
+        out[s++] = outputValue;
+
+        advance();
+        sampleOffset -= 1024;
+    }
+}
+
+int SincResampler::resample(const int* in, int n, int* out)
+{
+    return resampleInput(in, n, out);
+}
+
+int SincResampler::resampleConstant(int sample, int n, int* out)
+{
+    return resampleInput(ConstantInput{sample}, n, out);
+}
+
+template<typename Input>
+int SincResampler::processInput(Input in, int n, short* out, int scaleFactor)
+{
+    int raw[PROCESS_CHUNK];
+    int s = 0;
+
+    while (n > 0)
+    {
+        const int len = std::min(n, PROCESS_CHUNK);
+        const int r = resampleInput(in, len, raw);
+
+        for (int i = 0; i < r; i++)
+        {
+            out[s++] = scaleOutput(raw[i], scaleFactor);
+        }
+
+        in += len;
+        n -= len;
+    }
+
+    return s;
+}
+
+int SincResampler::process(const int* in, int n, short* out, int scaleFactor)
+{
+    return processInput(in, n, out, scaleFactor);
+}
+
+int SincResampler::processConstant(int sample, int n, short* out, int scaleFactor)
+{
+    return processInput(ConstantInput{sample}, n, out, scaleFactor);
+}
+
+void SincResampler::setRatioAdjustment(double ppm)
+{
+    if (phaseCount == 0)
+    {
+        // The tables cover all the phases, so only the step between them changes
+        adjustCyclesPerSample(baseCyclesPerSample, ppm, cyclesPerSample, cyclesPerSampleFraction);
+        return;
+    }
+
+    if (ppm == 0.)
+    {
+        if (!fixedPhases)
+        {
+            // Back to the phase sequence, from the nearest phase
+            const double offset = sampleOffset + sampleOffsetFraction / 4294967296.;
+            const int position = static_cast<int>(std::lround(offset * phaseCount / 1024.));
+            pending = position / phaseCount + 1;
+            phase = position % phaseCount;
+            fixedPhases = true;
+        }
+        return;
+    }
+
+    if (fixedPhases)
+    {
+        // Carry on from the next output with the interpolated phases
+        const double offset = ((pending - 1) * phaseCount + phase) * 1024. / phaseCount;
+        sampleOffset = static_cast<int>(offset);
+        sampleOffsetFraction = static_cast<std::uint32_t>((offset - sampleOffset) * 4294967296.);
+        fixedPhases = false;
+    }
+
+    // Adjust the exact ratio rather than the truncated one
+    adjustCyclesPerSample(phaseStep * 1024. / phaseCount, ppm, cyclesPerSample, cyclesPerSampleFraction);
+}
+
 void SincResampler::reset()
 {
     std::fill(std::begin(sample), std::end(sample), 0);
     sampleOffset = 0;
+    sampleOffsetFraction = 0;
+    phase = 0;
+    pending = 1;
+    lastInput = 0;
+    constantRun = firN + 1;
 }
 
 } // namespace reSIDfp
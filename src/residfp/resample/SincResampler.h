@@ -27,6 +27,10 @@
 
 #include "../array.h"
 
+#include <cstdint>
+#include <memory>
+#include <vector>
+
 namespace reSIDfp
 {
 
@@ -44,16 +48,47 @@ namespace reSIDfp
  * this implementation dramatically reduces the computational effort in the
  * filter convolutions, without any loss of accuracy.
  * The filter convolutions are also vectorizable on current hardware.
+ *
+ * Two convolutions per sample are linearly interpolated to get the exact phase.
+ * Alternatively, the tables can be made dense enough for the nearest one
+ * to be as accurate, which halves the work but takes up to 1024 tables
+ * instead of a few dozen: up to a few hundred KiB depending on the rates.
+ *
+ * When the ratio of the rates is a fraction with a small denominator,
+ * the outputs only ever fall on that many phases. Each one gets its own
+ * table, and the outputs follow the fixed sequence of the phases
+ * with a single convolution each.
+ *
+ * The filters are linear phase, with a delay of half their length.
+ * Their minimum phase counterparts, with the same magnitude response,
+ * put most of the energy in the first taps for a much lower delay
+ * at the price of some phase distortion near the end of the passband.
  */
 class SincResampler final : public Resampler
 {
+public:
+    /// Convolution of the samples with a FIR table, picked for the CPU
+    using convolve_t = int (*)(const short* a, const short* b, int bLength);
+
 private:
     /// Size of the ring buffer, must be a power of 2
     static constexpr int RINGSIZE = 2048;
 
+    /// Fixed cost of an output sample, in multiply-accumulates
+    static constexpr int OUTPUT_OVERHEAD = 512;
+
+    /// Most phases of a rational ratio of the rates to get a table each
+    static constexpr int MAX_RATIONAL_PHASES = 64;
+
 private:
-    /// Table of the fir filter coefficients
-    matrix_t* firTable;
+    /// Table of the fir filter coefficients, shared with the resamplers using the same rates
+    std::shared_ptr<matrix_t> firTable;
+
+    /// Convolution function
+    const convolve_t convolve;
+
+    /// Use the nearest of dense tables instead of interpolating between two
+    const bool densePhases;
 
     int sampleIndex = 0;
 
@@ -63,44 +98,233 @@ private:
     /// Filter length
     int firN;
 
-    const int cyclesPerSample;
+    /// Nominal number of cycles per sample
+    const int baseCyclesPerSample;
+
+    /// Number of cycles per sample, after the ratio adjustment
+    int cyclesPerSample;
+
+    /// Fraction of the cycles per sample below the 1/1024 units
+    std::uint32_t cyclesPerSampleFraction = 0;
 
     int sampleOffset = 0;
 
+    /// Fraction of the sample offset below the 1/1024 units
+    std::uint32_t sampleOffsetFraction = 0;
+
+    /// Number of phases of a rational ratio of the rates, 0 if there are too many
+    int phaseCount = 0;
+
+    /// Step between the phases of a rational ratio, in 1/phaseCount of a sample
+    int phaseStep = 0;
+
+    /// Whether the outputs follow the fixed phase sequence of the rational ratio,
+    /// until the ratio gets adjusted
+    bool fixedPhases = false;
+
+    /// Phase of the next output, in 1/phaseCount of a sample
+    int phase = 0;
+
+    /// Samples to input until the next output
+    int pending = 1;
+
+    /// For each phase, samples to input before the next output
+    std::vector<int> phaseAdvance;
+
+    /// For each phase, phase of the next output
+    std::vector<int> nextPhase;
+
     int outputValue = 0;
 
-    int sample[RINGSIZE * 2];
+    /// Last input sample
+    int lastInput = 0;
+
+    /// Number of consecutive identical input samples, up to firN + 1
+    int constantRun = 0;
+
+    /// Sum of the coefficients of each FIR table
+    std::vector<int> firSum;
+
+    /// Delay of the output, in seconds
+    double groupDelay;
+
+    /// Input history, mirrored so the convolutions never wrap
+    short sample[RINGSIZE * 2];
 
 private:
     int fir(int subcycle);
 
+    /// Move on to the next output sample
+    void advance();
+
+    /**
+     * Output for the current phase of a rational ratio, which has its own table.
+     */
+    int firFixed() const;
+
+    /**
+     * A run of identical samples, standing in for a block of input samples.
+     */
+    struct ConstantInput
+    {
+        int value;
+
+        ConstantInput operator+(int) const { return *this; }
+        ConstantInput& operator+=(int) { return *this; }
+    };
+
+    /**
+     * resample() or resampleConstant().
+     */
+    template<typename Input>
+    int resampleInput(Input in, int n, int* out);
+
+    /**
+     * resampleInput() following the fixed phase sequence of a rational ratio.
+     */
+    template<typename Input>
+    int resampleFixed(Input in, int n, int* out);
+
+    /**
+     * process() or processConstant().
+     */
+    template<typename Input>
+    int processInput(Input in, int n, short* out, int scaleFactor);
+
+    /**
+     * Store samples into the ring buffer and track the run of identical samples.
+     */
+    void ingest(const int* in, int n);
+
+    /**
+     * Same as above for a run of identical samples,
+     * only the part of it that can still be read back is stored.
+     */
+    void ingest(ConstantInput in, int n);
+
 public:
     /**
      * Use a clock freqency of 985248Hz for PAL C64, 1022730Hz for NTSC C64.
      *
-     * For resampling, the ratio between the clock frequency
-     * and the sample frequency is limited as follows:
-     *   125*clock_freq/sample_freq < 16384
-     *
-     * E.g. provided a clock frequency of ~ 1MHz, the sample frequency
-     * can not be set lower than ~ 8kHz.
-     * A lower sample frequency would make the resampling code overfill
-     * its 16k sample ring buffer.
+     * The filter must fit in the ring buffer, which limits the ratio
+     * between the clock frequency and the sample frequency, see cost().
+     * Lower sample frequencies are handled by CascadeResampler.
      *
      * @param clockFrequency System clock frequency at Hz
      * @param samplingFrequency Desired output sampling rate
      * @param highestAccurateFrequency passband frequency limit
+     * @param minimumPhase use a minimum phase filter instead of a linear phase one
+     * @param densePhases use dense tables and a single convolution
      */
     SincResampler(
         double clockFrequency,
         double samplingFrequency,
-        double highestAccurateFrequency);
+        double highestAccurateFrequency,
+        bool minimumPhase = false,
+        bool densePhases = false);
     ~SincResampler() override;
 
+    /**
+     * Order of a Kaiser windowed filter with 16 bit stopband attenuation.
+     *
+     * @param dw width of the transition band, in radians per sample
+     */
+    static int kaiserOrder(double dw);
+
+    /**
+     * Kaiser window for 16 bit stopband attenuation.
+     *
+     * @param xt position in the window, from -1 to 1
+     */
+    static double kaiserWindow(double xt);
+
+    /**
+     * Length of the FIR filter for the given rates.
+     *
+     * @param clockFrequency input sampling rate
+     * @param samplingFrequency output sampling rate
+     * @param highestAccurateFrequency passband frequency limit
+     * @return number of taps
+     */
+    static int firLength(
+        double clockFrequency,
+        double samplingFrequency,
+        double highestAccurateFrequency);
+
+    /**
+     * Number of phases of the ratio of the rates, if it's a fraction with small terms.
+     *
+     * @param clockFrequency input sampling rate
+     * @param samplingFrequency output sampling rate
+     * @return the denominator of the ratio, 0 if it's too large
+     */
+    static int rationalPhases(double clockFrequency, double samplingFrequency);
+
+    /**
+     * Relative cost of an output sample for the given rates,
+     * in vectorized multiply-accumulates, including the per sample overhead.
+     *
+     * @param clockFrequency input sampling rate
+     * @param samplingFrequency output sampling rate
+     * @param highestAccurateFrequency passband frequency limit
+     * @return cost, infinite if the rates aren't supported
+     */
+    static double cost(
+        double clockFrequency,
+        double samplingFrequency,
+        double highestAccurateFrequency);
+
+    /**
+     * All the convolutions the CPU supports, the plain C++ one first.
+     * They all give the same results, whichever one is picked.
+     */
+    static std::vector<convolve_t> convolutions();
+
+    /// Number of FIR tables
+    int getFirCount() const { return firRES; }
+
+    /// Number of taps of the FIR tables
+    int getFirLength() const { return firN; }
+
+    /**
+     * Get a FIR table, e.g. to run the convolutions on it.
+     *
+     * @param i the table, less than getFirCount()
+     */
+    const short* getFir(int i) const { return (*firTable)[i]; }
+
     bool input(int input) override;
 
+    int process(const int* in, int n, short* out, int scaleFactor) override;
+
+    int processConstant(int sample, int n, short* out, int scaleFactor) override;
+
+    /**
+     * Input a block of samples, storing the unscaled output samples.
+     *
+     * @param in input samples
+     * @param n number of input samples
+     * @param out output buffer, with room for at least n samples
+     * @return number of samples stored in out
+     */
+    int resample(const int* in, int n, int* out);
+
+    /**
+     * Same as resample() with n copies of the same sample.
+     *
+     * @param sample input sample
+     * @param n number of input samples
+     * @param out output buffer, with room for at least n samples
+     * @return number of samples stored in out
+     */
+    int resampleConstant(int sample, int n, int* out);
+
     int output() const override { return outputValue; }
 
+    double delay() const override { return groupDelay; }
+
+    void setRatioAdjustment(double ppm) override;
+
     void reset() override;
 };
 
@@ -22,6 +22,7 @@
 #ifndef TWOPASSSINCRESAMPLER_H
 #define TWOPASSSINCRESAMPLER_H
 
+#include <algorithm>
 #include <cmath>
 
 #include <memory>
@@ -44,32 +45,98 @@ private:
     std::unique_ptr<SincResampler> const s2;
 
 private:
-    TwoPassSincResampler(double clockFrequency, double samplingFrequency, double highestAccurateFrequency, double intermediateFrequency) :
-        s1(new SincResampler(clockFrequency, intermediateFrequency, highestAccurateFrequency)),
-        s2(new SincResampler(intermediateFrequency, samplingFrequency, highestAccurateFrequency))
+    TwoPassSincResampler(double clockFrequency, double samplingFrequency, double highestAccurateFrequency, double intermediateFrequency, bool minimumPhase, bool densePhases) :
+        s1(new SincResampler(clockFrequency, intermediateFrequency, highestAccurateFrequency, minimumPhase, densePhases)),
+        s2(new SincResampler(intermediateFrequency, samplingFrequency, highestAccurateFrequency, minimumPhase, densePhases))
     {}
 
+    /// Number of intermediate frequencies tried by the cost model
+    static constexpr int INTERMEDIATE_STEPS = 256;
+
 public:
-    // Named constructor
-    static TwoPassSincResampler* create(double clockFrequency, double samplingFrequency)
+    /**
+     * Default end of passband, slightly below half sampling frequency
+     *   pass_freq <= 0.9*sample_freq/2
+     *
+     * This constraint ensures that the FIR table is not overfilled.
+     * For higher sampling frequencies we're fine with 20KHz
+     *
+     * @param samplingFrequency output sampling rate
+     * @return passband frequency limit
+     */
+    static double defaultPassband(double samplingFrequency)
+    {
+        return (samplingFrequency > 44000.) ? 20000. : samplingFrequency * 0.45;
+    }
+
+    /**
+     * Find the cheapest layout for the requested passband,
+     * either a single SINC or two chained ones.
+     *
+     * @param clockFrequency System clock frequency at Hz
+     * @param samplingFrequency Desired output sampling rate
+     * @param highestAccurateFrequency passband frequency limit
+     * @param intermediateFrequency set to the intermediate frequency of two chained SINCs,
+     *        0 for a single one
+     * @return multiply-accumulates per output sample, infinite if no layout fits
+     */
+    static double bestLayout(double clockFrequency, double samplingFrequency, double highestAccurateFrequency, double& intermediateFrequency)
     {
-        // Set the passband frequency slightly below half sampling frequency
-        //   pass_freq <= 0.9*sample_freq/2
-        //
-        // This constraint ensures that the FIR table is not overfilled.
-        // For higher sampling frequencies we're fine with 20KHz
-        const double halfFreq = (samplingFrequency > 44000.)
-            ? 20000. : samplingFrequency * 0.45;
-
-        // Calculation according to Laurent Ganier.
-        // It evaluates to about 120 kHz at typical settings.
-        // Some testing around the chosen value seems to confirm that this does work.
-        double const intermediateFrequency = 2. * halfFreq
-            + std::sqrt(2. * halfFreq * clockFrequency
-                * (samplingFrequency - 2. * halfFreq) / samplingFrequency);
+        double bestCost = SincResampler::cost(clockFrequency, samplingFrequency, highestAccurateFrequency);
+        intermediateFrequency = 0.;
+
+        // Try intermediate frequencies evenly spaced on a log scale,
+        // the first pass has the same passband so it must satisfy
+        //   pass_freq <= 0.9*intermediate_freq/2
+        const double lowest = std::max(samplingFrequency, highestAccurateFrequency / 0.45);
+        const double step = std::pow(clockFrequency / lowest, 1. / INTERMEDIATE_STEPS);
+
+        double frequency = lowest;
+        for (int i = 1; i < INTERMEDIATE_STEPS; i++)
+        {
+            frequency *= step;
+
+            // The first pass produces frequency/samplingFrequency samples per output sample
+            const double cost = SincResampler::cost(clockFrequency, frequency, highestAccurateFrequency) * frequency / samplingFrequency
+                + SincResampler::cost(frequency, samplingFrequency, highestAccurateFrequency);
+
+            if (cost < bestCost)
+            {
+                bestCost = cost;
+                intermediateFrequency = frequency;
+            }
+        }
+
+        return bestCost;
+    }
+
+    /**
+     * Named constructor.
+     *
+     * Chooses between a single SINC and two chained ones, and the intermediate
+     * frequency of the latter, so that the fewest multiply-accumulates
+     * are needed per output sample for the requested passband.
+     *
+     * @param clockFrequency System clock frequency at Hz
+     * @param samplingFrequency Desired output sampling rate
+     * @param highestAccurateFrequency passband frequency limit, the default one if not positive
+     * @param minimumPhase use minimum phase filters, for a lower delay
+     * @param densePhases use dense tables and a single convolution per sample
+     */
+    static Resampler* create(double clockFrequency, double samplingFrequency, double highestAccurateFrequency = 0., bool minimumPhase = false, bool densePhases = false)
+    {
+        const double halfFreq = (highestAccurateFrequency > 0.)
+            ? highestAccurateFrequency : defaultPassband(samplingFrequency);
+
+        // Dense phases don't change the layout, so the output stays the same
+        double intermediateFrequency;
+        bestLayout(clockFrequency, samplingFrequency, halfFreq, intermediateFrequency);
+
+        if (intermediateFrequency == 0.)
+            return new SincResampler(clockFrequency, samplingFrequency, halfFreq, minimumPhase, densePhases);
 
         return new TwoPassSincResampler(
-            clockFrequency, samplingFrequency, halfFreq, intermediateFrequency);
+            clockFrequency, samplingFrequency, halfFreq, intermediateFrequency, minimumPhase, densePhases);
     }
 
     bool input(int sample) override
@@ -77,11 +144,75 @@ public:
         return s1->input(sample) && s2->input(s1->output());
     }
 
+    int process(const int* in, int n, short* out, int scaleFactor) override
+    {
+        int intermediate[PROCESS_CHUNK];
+        int raw[PROCESS_CHUNK];
+        int s = 0;
+
+        while (n > 0)
+        {
+            const int len = std::min(n, PROCESS_CHUNK);
+            const int m = s1->resample(in, len, intermediate);
+            const int r = s2->resample(intermediate, m, raw);
+
+            for (int i = 0; i < r; i++)
+            {
+                out[s++] = scaleOutput(raw[i], scaleFactor);
+            }
+
+            in += len;
+            n -= len;
+        }
+
+        return s;
+    }
+
+    int processConstant(int sample, int n, short* out, int scaleFactor) override
+    {
+        int intermediate[PROCESS_CHUNK];
+        int raw[PROCESS_CHUNK];
+        int s = 0;
+
+        while (n > 0)
+        {
+            const int len = std::min(n, PROCESS_CHUNK);
+            const int m = s1->resampleConstant(sample, len, intermediate);
+
+            // Once the first pass has settled its output is constant too
+            const bool constant = (m > 0)
+                && std::all_of(intermediate + 1, intermediate + m, [&intermediate](int x) { return x == intermediate[0]; });
+            const int r = constant
+                ? s2->resampleConstant(intermediate[0], m, raw)
+                : s2->resample(intermediate, m, raw);
+
+            for (int i = 0; i < r; i++)
+            {
+                out[s++] = scaleOutput(raw[i], scaleFactor);
+            }
+
+            n -= len;
+        }
+
+        return s;
+    }
+
     int output() const override
     {
         return s2->output();
     }
 
+    double delay() const override
+    {
+        return s1->delay() + s2->delay();
+    }
+
+    void setRatioAdjustment(double ppm) override
+    {
+        // The intermediate rate doesn't need to follow
+        s2->setRatioAdjustment(ppm);
+    }
+
     void reset() override
     {
         s1->reset();
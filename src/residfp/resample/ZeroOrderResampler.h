@@ -41,21 +41,46 @@ private:
     /// Last sample
     int cachedSample;
 
-    /// Number of cycles per sample
-    const int cyclesPerSample;
+    /// Nominal number of cycles per sample
+    const int baseCyclesPerSample;
+
+    /// Number of cycles per sample, after the ratio adjustment
+    int cyclesPerSample;
+
+    /// Fraction of the cycles per sample below the 1/1024 units
+    std::uint32_t cyclesPerSampleFraction = 0;
 
     int sampleOffset;
 
+    /// Fraction of the sample offset below the 1/1024 units
+    std::uint32_t sampleOffsetFraction = 0;
+
     /// Calculated sample
     int outputValue;
 
+    /// Half a cycle on average, from interpolating between the last two samples
+    const double groupDelay;
+
 public:
     ZeroOrderResampler(double clockFrequency, double samplingFrequency) :
         cachedSample(0),
-        cyclesPerSample(static_cast<int>(clockFrequency / samplingFrequency * 1024.)),
+        baseCyclesPerSample(static_cast<int>(clockFrequency / samplingFrequency * 1024.)),
+        cyclesPerSample(baseCyclesPerSample),
         sampleOffset(0),
-        outputValue(0) {}
+        outputValue(0),
+        groupDelay(0.5 / clockFrequency) {}
 
+private:
+    /// Move on to the next output sample
+    void advance()
+    {
+        sampleOffset += cyclesPerSample;
+        sampleOffsetFraction += cyclesPerSampleFraction;
+        if (sampleOffsetFraction < cyclesPerSampleFraction)
+            sampleOffset++;
+    }
+
+public:
     bool input(int sample) override
     {
         bool ready = false;
@@ -64,7 +89,7 @@ public:
         {
             outputValue = cachedSample + (sampleOffset * (sample - cachedSample) >> 10);
             ready = true;
-            sampleOffset += cyclesPerSample;
+            advance();
         }
 
         sampleOffset -= 1024;
@@ -74,11 +99,53 @@ public:
         return ready;
     }
 
+    int process(const int* in, int n, short* out, int scaleFactor) override
+    {
+        int s = 0;
+        int i = 0;
+
+        for (;;)
+        {
+            // Number of samples to skip until the next output is due
+            const int skip = sampleOffset >> 10;
+
+            if (i + skip >= n)
+            {
+                sampleOffset -= (n - i) << 10;
+                break;
+            }
+
+            i += skip;
+            sampleOffset -= skip << 10;
+
+            const int prev = (i > 0) ? in[i - 1] : cachedSample;
+            outputValue = prev + (sampleOffset * (in[i] - prev) >> 10);
+            out[s++] = getOutput(scaleFactor);
+
+            advance();
+            sampleOffset -= 1024;
+            i++;
+        }
+
+        if (n > 0)
+            cachedSample = in[n - 1];
+
+        return s;
+    }
+
     int output() const override { return outputValue; }
 
+    double delay() const override { return groupDelay; }
+
+    void setRatioAdjustment(double ppm) override
+    {
+        adjustCyclesPerSample(baseCyclesPerSample, ppm, cyclesPerSample, cyclesPerSampleFraction);
+    }
+
     void reset() override
     {
         sampleOffset = 0;
+        sampleOffsetFraction = 0;
         cachedSample = 0;
     }
 };
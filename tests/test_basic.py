@@ -1,6 +1,60 @@
+import math
+import os
+import subprocess
+import sys
 from datetime import timedelta
 
+import pytest
+
 from pyresidfp import SoundInterfaceDevice, Voice, ControlBits, Tone
+from pyresidfp._pyresidfp import (
+    ChipModel,
+    ChipProfile,
+    CombinedWaveforms,
+    Quality,
+    SamplingMethod,
+)
+
+
+def play(sid, waveform=ControlBits.SAWTOOTH, tone=Tone.C4, seconds=0.1, filtered=False):
+    """Plays a sustained tone on voice one at maximum volume, returns the samples"""
+    if filtered:
+        sid.Filter_Mode_Vol = 0x1F  # Lowpass, maximum volume
+        sid.Filter_Res_Filt = 0x01  # Voice one through the filter
+    else:
+        sid.Filter_Mode_Vol = 15  # Maximum volume
+    sid.sustain_release(Voice.ONE, 0xF0)
+    sid.tone(Voice.ONE, tone)
+    sid.control(Voice.ONE, waveform | ControlBits.GATE)
+    return sid.clock(timedelta(seconds=seconds))
+
+
+def tone_frequency(sid, tone):
+    """Frequency of a tone at the clock frequency of the chip"""
+    return tone.value * sid.clock_frequency / (1 << 24)
+
+
+def amplitude(samples, sampling_frequency, frequency):
+    """Amplitude of a frequency in the samples, with a Hann window"""
+    n = len(samples)
+    step = 2 * math.pi * frequency / sampling_frequency
+    re = im = 0.0
+    for i, sample in enumerate(samples):
+        weight = sample * (0.5 - 0.5 * math.cos(2 * math.pi * i / n))
+        re += weight * math.cos(step * i)
+        im -= weight * math.sin(step * i)
+    return 4 * math.hypot(re, im) / n
+
+
+def harmonics(sid, samples, tone=Tone.C4, highest=None):
+    """Amplitudes of the harmonics of a tone up to a frequency, without the first 10 ms"""
+    fundamental = tone_frequency(sid, tone)
+    highest = highest or sid.sampling_frequency / 2
+    steady = samples[int(0.01 * sid.sampling_frequency):]
+    return {
+        k * fundamental: amplitude(steady, sid.sampling_frequency, k * fundamental)
+        for k in range(1, int(highest / fundamental) + 1)
+    }
 
 
 def test_sample_length():
@@ -32,3 +86,241 @@ def test_sample_length():
         <= len(raw_samples)
         <= expected_vector_length + error_margin
     )
+
+
+def test_quality():
+    """Faster quality levels produce the same number of samples"""
+    sid = SoundInterfaceDevice()
+    assert sid.quality == Quality.REFERENCE
+
+    for quality in (Quality.REFERENCE, Quality.FAST, Quality.DRAFT):
+        sid.quality = quality
+        assert sid.quality == quality
+        raw_samples = play(sid, filtered=True)
+        assert len(raw_samples) == pytest.approx(0.1 * sid.sampling_frequency, rel=0.01)
+        assert any(raw_samples)
+
+
+def test_cache_directory(tmp_path):
+    """Filter tables are written to the cache directory and reused"""
+    script = (
+        "from datetime import timedelta\n"
+        "from pyresidfp import SoundInterfaceDevice\n"
+        "sid = SoundInterfaceDevice()\n"
+        "sid.Filter_Mode_Vol = 0x1F\n"
+        "assert len(sid.clock(timedelta(seconds=0.01))) > 0\n"
+    )
+    env = dict(os.environ, PYRESIDFP_CACHE_DIR=str(tmp_path))
+
+    subprocess.run([sys.executable, "-c", script], env=env, check=True)
+    cached = sorted(tmp_path.glob("residfp-*.tables"))
+    assert len(cached) == 1
+
+    # The second process maps the cached tables
+    subprocess.run([sys.executable, "-c", script], env=env, check=True)
+    assert sorted(tmp_path.glob("residfp-*.tables")) == cached
+
+
+def test_compact_tables():
+    """Compact filter tables closely follow the full ones"""
+
+    def render(compact):
+        sid = SoundInterfaceDevice()
+        sid.compact_tables = compact
+        assert sid.compact_tables == compact
+        return play(sid, filtered=True)
+
+    full = render(False)
+    compact = render(True)
+    assert len(compact) == len(full)
+    assert max(abs(a - b) for a, b in zip(full, compact)) < 256
+
+
+def test_chip_profile():
+    """Chip profiles switch the chip model without resetting the chip"""
+    sid = SoundInterfaceDevice(model=ChipModel.MOS8580)
+    play(sid, ControlBits.TRIANGLE | ControlBits.SAWTOOTH, seconds=0)
+
+    for profile, model in (
+        (ChipProfile.MOS6581R2, ChipModel.MOS6581),
+        (ChipProfile.MOS8580R5_STRONG, ChipModel.MOS8580),
+    ):
+        sid.set_chip_profile(profile)
+        assert sid.chip_model == model
+        assert any(sid.clock(timedelta(seconds=0.1)))
+
+
+def play_and_change(waveform, filtered, change):
+    """Plays the same note on two 6581, changes a setting of one of them in the middle,
+    returns the rest of the note from both"""
+    kept, changed = (SoundInterfaceDevice(model=ChipModel.MOS6581) for _ in range(2))
+    assert play(kept, waveform, seconds=0.05, filtered=filtered) == play(
+        changed, waveform, seconds=0.05, filtered=filtered
+    )
+    change(changed)
+    return kept.clock(timedelta(seconds=0.05)), changed.clock(timedelta(seconds=0.05))
+
+
+@pytest.mark.parametrize("cws", [CombinedWaveforms.WEAK, CombinedWaveforms.STRONG])
+def test_combined_waveforms(cws):
+    """Combined waveforms strength takes effect in the middle of a note"""
+
+    def change(sid):
+        assert sid.combined_waveforms == CombinedWaveforms.AVERAGE
+        sid.combined_waveforms = cws
+        assert sid.combined_waveforms == cws
+
+    before, after = play_and_change(ControlBits.TRIANGLE | ControlBits.SAWTOOTH, False, change)
+    assert len(before) == len(after)
+    assert sum(a != b for a, b in zip(before, after)) > len(before) // 2
+
+
+def test_filter_6581_range():
+    """The 6581 filter range takes effect in the middle of a note"""
+    before, after = play_and_change(ControlBits.SAWTOOTH, True, lambda sid: sid.set_filter_6581_range(0.8))
+    assert len(before) == len(after)
+    assert sum(a != b for a, b in zip(before, after)) > len(before) // 2
+
+
+def test_chip_model_switch():
+    """Switching the chip model sounds the same as starting with it"""
+    for first, second in (
+        (ChipModel.MOS8580, ChipModel.MOS6581),
+        (ChipModel.MOS6581, ChipModel.MOS8580),
+    ):
+        switched = SoundInterfaceDevice(model=first)
+        switched.chip_model = second
+        assert switched.chip_model == second
+        assert play(switched, filtered=True) == play(
+            SoundInterfaceDevice(model=second), filtered=True
+        )
+
+
+def test_independent_filter_settings():
+    """The filter range of one chip doesn't change another one"""
+
+    def device(adjustment):
+        sid = SoundInterfaceDevice(model=ChipModel.MOS6581)
+        sid.set_filter_6581_range(adjustment)
+        return sid
+
+    alone = play(device(0.2), filtered=True)
+
+    first = device(0.2)
+    second = device(0.9)
+    assert play(first, filtered=True) == alone
+    assert play(second, filtered=True) != alone
+
+
+def test_passband_frequency():
+    """A narrower passband is reproduced as before, the top of the spectrum rolls off"""
+    full = SoundInterfaceDevice()
+    narrow = SoundInterfaceDevice(passband_frequency=8000.0)
+    assert narrow.passband_frequency == 8000.0
+
+    raw_full = play(full)
+    raw_narrow = play(narrow)
+    assert len(raw_narrow) == len(raw_full)
+
+    full_harmonics = harmonics(full, raw_full)
+    narrow_harmonics = harmonics(narrow, raw_narrow)
+    for frequency, value in full_harmonics.items():
+        if frequency < 8000.0:
+            assert narrow_harmonics[frequency] == pytest.approx(value, rel=0.01)
+
+    top = [f for f in full_harmonics if 20000.0 <= f <= 23000.0]
+    assert sum(narrow_harmonics[f] for f in top) < 0.85 * sum(full_harmonics[f] for f in top)
+
+    with pytest.raises(RuntimeError):
+        narrow.passband_frequency = 0.5 * narrow.sampling_frequency
+
+
+@pytest.mark.parametrize("sampling_frequency", [2000.0, 4000.0])
+def test_low_sampling_frequency(sampling_frequency):
+    """Sample rates well below 8 kHz are supported, and the tone stays in place"""
+    sid = SoundInterfaceDevice(sampling_frequency=sampling_frequency)
+    raw_samples = play(sid, ControlBits.TRIANGLE, Tone.A4, seconds=0.5)
+    assert len(raw_samples) == pytest.approx(0.5 * sampling_frequency, rel=0.01)
+
+    # The strongest component is the tone, aliases of its harmonics stay below
+    fundamental = tone_frequency(sid, Tone.A4)
+    peak = amplitude(raw_samples, sampling_frequency, fundamental)
+    others = [
+        amplitude(raw_samples, sampling_frequency, frequency)
+        for frequency in range(20, int(sampling_frequency / 2), 10)
+        if abs(frequency - fundamental) > 30
+    ]
+    assert peak > 4 * max(others)
+
+
+def test_minimum_phase_delay():
+    """Minimum phase resampling has the same magnitude response with a lower delay"""
+    linear = SoundInterfaceDevice(sampling_method=SamplingMethod.RESAMPLE)
+    minimum = SoundInterfaceDevice(
+        sampling_method=SamplingMethod.RESAMPLE_MINIMUM_PHASE
+    )
+    assert timedelta(0) < minimum.delay < linear.delay / 2
+
+    raw_linear = play(linear)
+    raw_minimum = play(minimum)
+    assert len(raw_minimum) == len(raw_linear)
+
+    linear_harmonics = harmonics(linear, raw_linear, highest=20000.0)
+    minimum_harmonics = harmonics(minimum, raw_minimum, highest=20000.0)
+    for frequency, value in linear_harmonics.items():
+        assert minimum_harmonics[frequency] == pytest.approx(value, rel=0.01)
+
+
+def test_ratio_adjustment():
+    """Adjusting the ratio changes the number of samples accordingly"""
+    sid = SoundInterfaceDevice()
+    nominal = len(play(sid, seconds=0.5))
+
+    sid.ratio_adjustment = 5000.0
+    assert sid.ratio_adjustment == 5000.0
+    faster = len(sid.clock(timedelta(seconds=0.5)))
+    assert faster == pytest.approx(nominal * 1.005, abs=2)
+
+    sid.ratio_adjustment = -5000.0
+    slower = len(sid.clock(timedelta(seconds=0.5)))
+    assert slower == pytest.approx(nominal / 1.005, abs=2)
+
+    with pytest.raises(RuntimeError):
+        sid.ratio_adjustment = 20000.0
+
+
+def test_dense_phase_tables():
+    """Dense phase tables give the same samples, give or take the rounding"""
+
+    def render(dense):
+        sid = SoundInterfaceDevice()
+        sid.dense_phase_tables = dense
+        assert sid.dense_phase_tables == dense
+        return play(sid)
+
+    interpolated = render(False)
+    dense = render(True)
+    assert len(dense) == len(interpolated)
+    assert max(abs(a - b) for a, b in zip(interpolated, dense)) <= 8
+
+
+@pytest.mark.parametrize("sampling_frequency", [48000.0, 62500.0])
+def test_rational_ratio(sampling_frequency):
+    """A rational ratio of the rates gives the exact number of samples"""
+    sid = SoundInterfaceDevice(
+        clock_frequency=1000000.0, sampling_frequency=sampling_frequency
+    )
+    raw_samples = play(sid, seconds=1)
+    assert len(raw_samples) == int(sampling_frequency)
+    assert any(raw_samples)
+
+
+def test_chip_profile_change():
+    """A chip profile takes effect in the middle of a note"""
+
+    def change(sid):
+        sid.set_chip_profile(ChipProfile.MOS6581R2_STRONG)
+
+    before, after = play_and_change(ControlBits.TRIANGLE | ControlBits.SAWTOOTH, False, change)
+    assert len(before) == len(after)
+    assert sum(a != b for a, b in zip(before, after)) > len(before) // 2
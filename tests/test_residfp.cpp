@@ -0,0 +1,697 @@
+/*
+ * This file is part of pyresidfp, a SID emulation package for Python.
+ *
+ * Copyright (c) 2018-2023.  Sebastian Klemke <pypi@nerdheim.de>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+/*
+ * Tests of the emulation core that can't be observed through the Python API,
+ * mostly the equivalence of the fast paths with the straightforward ones.
+ */
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <memory>
+#include <random>
+#include <thread>
+#include <vector>
+
+#include "FilterTableCache.h"
+#include "SID.h"
+#include "WaveformCalculator.h"
+#include "WaveformGenerator.h"
+#include "resample/CascadeResampler.h"
+#include "resample/SincResampler.h"
+#include "resample/TwoPassSincResampler.h"
+#include "resample/ZeroOrderResampler.h"
+
+namespace sid = reSIDfp;
+
+namespace {
+
+    int failures = 0;
+
+/// Report a failed condition and leave the test
+#define CHECK(condition) \
+    do { \
+        if (!(condition)) { \
+            std::fprintf(stderr, "%s:%d: %s failed\n", __FILE__, __LINE__, #condition); \
+            failures++; \
+            return; \
+        } \
+    } while (0)
+
+    /**
+     * Play a filtered note with some resonance.
+     *
+     * @param chip the chip to play on, with the sampling parameters set
+     * @param cycles number of cycles to render
+     * @return the samples
+     */
+    std::vector<short> playNote(sid::SID &chip, unsigned int cycles) {
+        chip.write(0x18, 0x1f); // Low pass, maximum volume
+        chip.write(0x17, 0x81); // Voice 1 filtered, some resonance
+        chip.write(0x15, 0x05);
+        chip.write(0x16, 0x28);
+        chip.write(0x01, 0x1c);
+        chip.write(0x03, 0x06);
+        chip.write(0x05, 0x22);
+        chip.write(0x06, 0xa8);
+        chip.write(0x04, 0x61); // Sawtooth and pulse, gate
+
+        std::vector<short> samples(cycles);
+        samples.resize(chip.clock(cycles, samples.data()));
+        return samples;
+    }
+
+    /**
+     * Chip settings that keep their own filter parameters.
+     */
+    struct ChipSetup {
+        sid::ChipModel model;
+        double curve;
+        double range;
+
+        std::vector<short> render() const {
+            sid::SID chip(model);
+            chip.setSamplingParameters(985248., sid::RESAMPLE, 48000.);
+            if (model == sid::MOS6581) {
+                chip.setFilter6581Curve(curve);
+                chip.setFilter6581Range(range);
+            } else {
+                chip.setFilter8580Curve(curve);
+            }
+            return playNote(chip, 50000);
+        }
+    };
+
+    /**
+     * Chips with different filter settings, built concurrently while
+     * the shared tables are still being built, give the same samples
+     * as when they run one after another.
+     * This has to run first, before anything builds the shared tables.
+     */
+    void testConcurrentChips() {
+        const ChipSetup setups[] = {
+                {sid::MOS6581, 0.5, 0.5},
+                {sid::MOS6581, 0.2, 0.9},
+                {sid::MOS6581, 0.8, 0.9},
+                {sid::MOS6581, 0.2, 0.1},
+                {sid::MOS8580, 0.5, 0.},
+                {sid::MOS8580, 0.9, 0.},
+        };
+
+        std::vector<short> concurrent[std::size(setups)];
+        std::vector<std::thread> threads;
+        for (std::size_t i = 0; i < std::size(setups); i++)
+            threads.emplace_back([&setups, &concurrent, i]() { concurrent[i] = setups[i].render(); });
+        for (auto &thread: threads)
+            thread.join();
+
+        for (std::size_t i = 0; i < std::size(setups); i++) {
+            CHECK(!concurrent[i].empty());
+            CHECK(concurrent[i] == setups[i].render());
+        }
+
+        // Each setting changes the output on its own
+        CHECK(concurrent[1] != concurrent[2]);
+        CHECK(concurrent[1] != concurrent[3]);
+        CHECK(concurrent[4] != concurrent[5]);
+    }
+
+    /**
+     * The filter of the other chip model, created on the switch,
+     * picks up the settings made before, whatever they went through.
+     */
+    void testFilterSettingChanges() {
+        const std::vector<short> expected6581 = ChipSetup{sid::MOS6581, 0.3, 0.6}.render();
+        const std::vector<short> expected8580 = ChipSetup{sid::MOS8580, 0.3, 0.}.render();
+
+        sid::SID chip8580(sid::MOS8580);
+        chip8580.setSamplingParameters(985248., sid::RESAMPLE, 48000.);
+        for (double curve: {0.7, 0.1, 0.3}) {
+            chip8580.setFilter6581Curve(curve);
+            chip8580.setFilter6581Range(1. - curve);
+        }
+        chip8580.setFilter6581Range(0.6);
+        chip8580.setChipModel(sid::MOS6581);
+        chip8580.reset();
+        CHECK(playNote(chip8580, 50000) == expected6581);
+
+        sid::SID chip6581(sid::MOS6581);
+        chip6581.setSamplingParameters(985248., sid::RESAMPLE, 48000.);
+        for (double curve: {0.7, 0.1, 0.3})
+            chip6581.setFilter8580Curve(curve);
+        chip6581.setChipModel(sid::MOS8580);
+        chip6581.reset();
+        CHECK(playNote(chip6581, 50000) == expected8580);
+    }
+
+    /**
+     * All the convolutions the CPU supports give the same results,
+     * for all lengths and alignments.
+     */
+    void testConvolutions() {
+        std::mt19937 rng(41);
+
+        // Full range samples, and coefficients small enough for the sums not to overflow
+        std::vector<short> samples(400);
+        std::vector<short> coefficients(400);
+        for (auto &sample: samples)
+            sample = static_cast<short>(rng());
+        for (auto &coefficient: coefficients)
+            coefficient = static_cast<short>(static_cast<int>(rng() % 129) - 64);
+
+        const std::vector<sid::SincResampler::convolve_t> convolutions = sid::SincResampler::convolutions();
+        CHECK(!convolutions.empty());
+
+        for (int offset = 0; offset < 4; offset++) {
+            for (int length = 0; length <= 300; length++) {
+                const int expected = convolutions[0](samples.data() + offset, coefficients.data() + offset, length);
+                for (auto convolve: convolutions)
+                    CHECK(convolve(samples.data() + offset, coefficients.data() + offset, length) == expected);
+            }
+        }
+
+        // Real tables with full scale input of the same and the opposite sign
+        // as the coefficients, the sums of the widest ones don't fit in 32 bit
+        for (bool minimumPhase: {false, true}) {
+            for (double passband: {0., 20000.}) {
+                const sid::SincResampler resampler(985248., 48000., passband, minimumPhase);
+                const int length = resampler.getFirLength();
+
+                for (int i = 0; i < resampler.getFirCount(); i += 7) {
+                    const short *fir = resampler.getFir(i);
+
+                    for (int sign: {1, -1}) {
+                        std::vector<short> input(length);
+                        long long sum = 0;
+                        for (int j = 0; j < length; j++) {
+                            input[j] = static_cast<short>((fir[j] < 0) == (sign < 0) ? 32767 : -32768);
+                            sum += static_cast<long long>(input[j]) * fir[j];
+                        }
+
+                        const int expected = static_cast<int>((sum + (1 << 14)) >> 15);
+                        for (auto convolve: convolutions)
+                            CHECK(convolve(input.data(), fir, length) == expected);
+                    }
+                }
+            }
+        }
+    }
+
+    /**
+     * Set up the three waveform generators of a chip.
+     */
+    void setUpWaveforms(sid::WaveformGenerator *generators, sid::ChipModel model) {
+        sid::WaveformCalculator *const calculator = sid::WaveformCalculator::getInstance();
+
+        for (int i = 0; i < 3; i++) {
+            generators[i].setModel(model == sid::MOS6581);
+            generators[i].setWaveformModels(calculator->getWaveTable());
+            generators[i].setPulldownModels(calculator->buildPulldownTable(model, sid::AVERAGE));
+            generators[i].setFusedModels(calculator->buildFusedTable(model, sid::AVERAGE));
+            generators[i].setOtherWaveforms(&generators[(i + 2) % 3], &generators[(i + 1) % 3]);
+            generators[i].reset();
+        }
+    }
+
+    /**
+     * WaveformGenerator::outputBlock gives the same outputs as clock() and output()
+     * on every cycle, for random register writes without ring modulation or sync.
+     */
+    void testWaveformBlocks() {
+        std::mt19937 rng(26);
+
+        for (sid::ChipModel model: {sid::MOS6581, sid::MOS8580}) {
+            sid::WaveformGenerator cycle[3];
+            sid::WaveformGenerator block[3];
+            setUpWaveforms(cycle, model);
+            setUpWaveforms(block, model);
+
+            for (int write = 0; write < 3000; write++) {
+                const int v = static_cast<int>(rng() % 3);
+                const auto value = static_cast<unsigned char>(rng());
+
+                for (sid::WaveformGenerator *generators: {cycle, block}) {
+                    switch (write % 5) {
+                        case 0:
+                            generators[v].writeFREQ_LO(value);
+                            break;
+                        case 1:
+                            generators[v].writeFREQ_HI(value);
+                            break;
+                        case 2:
+                            generators[v].writePW_LO(value);
+                            break;
+                        case 3:
+                            generators[v].writePW_HI(value);
+                            break;
+                        default:
+                            // Ring modulation and sync need the other voices on every cycle
+                            generators[v].writeCONTROL_REG(value & ~0x06);
+                            break;
+                    }
+                }
+
+                // Mostly short stretches, with long ones to let the floating output fade
+                const unsigned int cycles = (rng() % 16 == 0) ? rng() % 200000 : rng() % 2000;
+
+                std::vector<unsigned int> expected[3];
+                for (unsigned int c = 0; c < cycles; c++) {
+                    for (auto &generator: cycle)
+                        generator.clock();
+                    for (int i = 0; i < 3; i++)
+                        expected[i].push_back(cycle[i].output());
+                }
+
+                std::vector<unsigned int> actual[3];
+                for (unsigned int done = 0; done < cycles;) {
+                    const unsigned int n = std::min(cycles - done, 1 + static_cast<unsigned int>(rng() % 100));
+                    for (int i = 0; i < 3; i++) {
+                        actual[i].resize(done + n);
+                        block[i].outputBlock(n, actual[i].data() + done);
+                    }
+                    done += n;
+                }
+
+                for (int i = 0; i < 3; i++) {
+                    CHECK(actual[i] == expected[i]);
+                    CHECK(block[i].readOSC() == cycle[i].readOSC());
+                    CHECK(block[i].readAccumulator() == cycle[i].readAccumulator());
+                }
+            }
+        }
+    }
+
+    /**
+     * The fused waveform tables match the waveform lookup followed by the
+     * combined waveform pulldown, for every waveform without noise,
+     * both pulse states, both chip models and all the pulldown strengths.
+     */
+    void testFusedWaveforms() {
+        sid::WaveformCalculator *const calculator = sid::WaveformCalculator::getInstance();
+        matrix_t &wave = *calculator->getWaveTable();
+
+        for (sid::ChipModel model: {sid::MOS6581, sid::MOS8580}) {
+            for (sid::CombinedWaveforms cws: {sid::AVERAGE, sid::WEAK, sid::STRONG}) {
+                matrix_t &pulldown = *calculator->buildPulldownTable(model, cws);
+                matrix_t &fused = *calculator->buildFusedTable(model, cws);
+
+                for (unsigned int waveform = 1; waveform < 8; waveform++) {
+                    // Pulldown rows of the combined waveforms, as selected by the control register
+                    const short *rows[8] = {
+                            nullptr, nullptr, nullptr, pulldown[0], nullptr, pulldown[1], pulldown[2], pulldown[3]
+                    };
+                    const short *rowPulldown = rows[waveform];
+
+                    for (unsigned int pulse: {0x000u, 0xfffu}) {
+                        // Without the pulse waveform the pulse mask is all ones
+                        const unsigned int mask = (waveform & 0x4) ? pulse : 0xfff;
+
+                        for (unsigned int ix = 0; ix < (1u << 12); ix++) {
+                            unsigned int unfused = wave[waveform & 0x3][ix] & mask;
+                            if (rowPulldown != nullptr)
+                                unfused = rowPulldown[unfused];
+
+                            CHECK((fused[waveform][ix] & mask) == unfused);
+                        }
+                    }
+                }
+            }
+        }
+    }
+
+    /**
+     * Play a short note, hold the voices idle for two seconds, then play another one.
+     * Writing alternate values to a register that doesn't affect the output
+     * more often than the filter can settle keeps it running,
+     * i.e. disables the steady state shortcut.
+     *
+     * @param quality emulation quality
+     * @param keepFilterRunning whether to keep the filter running
+     * @param held set to whether the output was held at the end of the idle stretch
+     * @return the samples
+     */
+    std::vector<short> renderIdle(sid::Quality quality, bool keepFilterRunning, bool &held) {
+        sid::SID chip(sid::MOS6581);
+        chip.setSamplingParameters(985248., sid::RESAMPLE, 48000.);
+        chip.setQuality(quality);
+
+        chip.write(0x18, 0x1f); // Low pass, maximum volume
+        chip.write(0x17, 0x01); // Voice 1 filtered
+        chip.write(0x16, 0x40);
+        chip.write(0x01, 0x1c);
+        chip.write(0x05, 0x00);
+        chip.write(0x06, 0xf0);
+        chip.write(0x04, 0x21); // Sawtooth, gate
+
+        std::vector<short> samples(3 * 985248);
+        int n = chip.clock(98525, samples.data());
+
+        // Release quickly and hold the sawtooth with the test bit
+        chip.write(0x06, 0x00);
+        chip.write(0x04, 0x28);
+
+        for (int i = 0; i < 1970; i++) {
+            if (keepFilterRunning)
+                chip.write(0x10, static_cast<unsigned char>(i & 1)); // Voice 3 pulse width, no pulse waveform
+            n += chip.clock(1000, samples.data() + n);
+        }
+        held = chip.isOutputHeld();
+
+        chip.write(0x06, 0xf0);
+        chip.write(0x04, 0x21);
+        n += chip.clock(98525, samples.data() + n);
+
+        samples.resize(n);
+        return samples;
+    }
+
+    /**
+     * Holding the output of the settled filter, and then the constant output
+     * of the settled external filter, gives the same samples as clocking them,
+     * also once the next note starts.
+     * The dithered inputs only settle with the linearized filters.
+     */
+    void testSteadyState() {
+        for (sid::Quality quality: {sid::REFERENCE, sid::FAST, sid::DRAFT}) {
+            bool held = false;
+            bool running = true;
+            const std::vector<short> shortcut = renderIdle(quality, false, held);
+            const std::vector<short> full = renderIdle(quality, true, running);
+
+            CHECK(!running);
+            CHECK(held || (quality == sid::REFERENCE));
+            CHECK(shortcut == full);
+        }
+    }
+
+    /**
+     * Block sizes that cross the BLOCK_CYCLES and PROCESS_CHUNK boundaries
+     * in every possible way, mixed with random ones.
+     */
+    unsigned int chunkSize(std::mt19937 &rng) {
+        static const unsigned int sizes[] = {1, 2, 31, 255, 256, 257, 511, 512, 513, 4096};
+        return (rng() % 2 == 0) ? sizes[rng() % 10] : 1 + rng() % 3000;
+    }
+
+    /**
+     * Resampler::process and Resampler::processConstant, on the runs of identical samples,
+     * give the same samples as input() and getOutput() on every cycle, for every kind of resampler.
+     */
+    void testResamplerBlocks() {
+        struct Setup {
+            double clockFrequency;
+            double samplingFrequency;
+            double passband;
+            bool minimumPhase;
+            bool densePhases;
+            double ppm;
+        };
+        const Setup setups[] = {
+                {985248., 48000., 0., false, false, 0.},
+                {985248., 48000., 0., true, false, 0.},
+                {985248., 44100., 0., false, true, 0.},
+                {985248., 44100., 0., true, true, 0.},
+                {985248., 96000., 0., false, false, 0.},
+                {985248., 22050., 8000., false, false, 0.},
+                {985248., 8000., 0., false, true, 0.},
+                {985248., 8000., 0., true, false, 0.},
+                {1024000., 48000., 0., false, false, 0.},    // rational ratio
+                {1024000., 48000., 0., false, true, 0.},
+                {985248., 48000., 0., false, false, 250.},
+                {985248., 48000., 0., false, true, -3000.},
+        };
+
+        // A sweep with some noise, loud enough to clip at times,
+        // and runs of identical samples, some longer than the filters
+        std::mt19937 rng(44);
+        std::vector<int> input(250000);
+        for (std::size_t i = 0; i < input.size(); i++) {
+            const double t = static_cast<double>(i);
+            input[i] = static_cast<int>(30000. * std::sin(t * 1e-3 * (1. + t * 1e-5))) + static_cast<int>(rng() % 4001) - 2000;
+        }
+        static const int runs[] = {2, 7, 300, 3000, 9000, 20000};
+        for (std::size_t start = 10000; start < input.size(); start += 30000) {
+            const int value = (start == 130000) ? 40000 : input[start];
+            std::fill_n(input.begin() + start, std::min<std::size_t>(runs[rng() % 6], input.size() - start), value);
+        }
+
+        for (int method = 0; method <= static_cast<int>(std::size(setups)); method++) {
+            std::unique_ptr<sid::Resampler> cycle;
+            std::unique_ptr<sid::Resampler> block;
+            if (method == static_cast<int>(std::size(setups))) {
+                cycle.reset(new sid::ZeroOrderResampler(985248., 48000.));
+                block.reset(new sid::ZeroOrderResampler(985248., 48000.));
+            } else {
+                const Setup &setup = setups[method];
+                for (auto *resampler: {&cycle, &block}) {
+                    resampler->reset(sid::CascadeResampler::create(setup.clockFrequency, setup.samplingFrequency,
+                                                                   setup.passband, setup.minimumPhase,
+                                                                   setup.densePhases));
+                    (*resampler)->setRatioAdjustment(setup.ppm);
+                }
+            }
+
+            std::vector<short> expected;
+            for (int sample: input) {
+                if (cycle->input(sample))
+                    expected.push_back(cycle->getOutput(3));
+            }
+
+            std::vector<short> actual(input.size());
+            int n = 0;
+            for (std::size_t done = 0; done < input.size();) {
+                const auto len = static_cast<int>(std::min<std::size_t>(input.size() - done, chunkSize(rng)));
+
+                int run = 1;
+                while ((run < len) && (input[done + run] == input[done]))
+                    run++;
+
+                if (run > 1) {
+                    n += block->processConstant(input[done], run, actual.data() + n, 3);
+                    done += run;
+                } else {
+                    n += block->process(input.data() + done, len, actual.data() + n, 3);
+                    done += len;
+                }
+            }
+            actual.resize(n);
+
+            CHECK(!expected.empty());
+            CHECK(actual == expected);
+        }
+    }
+
+    /**
+     * Level of the alias of a loud tone, from a Hann windowed DFT of the output.
+     *
+     * @param resampler the resampler, from 985248 Hz
+     * @param samplingFrequency its output rate
+     * @param frequency the frequency of the tone, in the stopband
+     * @return the level in dB relative to the tone
+     */
+    double aliasLevel(sid::Resampler &resampler, double samplingFrequency, double frequency) {
+        const double clockFrequency = 985248.;
+        const double twoPi = 2. * 3.14159265358979323846;
+        std::vector<int> input(98525);
+        for (std::size_t i = 0; i < input.size(); i++)
+            input[i] = static_cast<int>(std::lround(32000. * std::sin(twoPi * frequency * i / clockFrequency)));
+
+        std::vector<short> output(input.size());
+        output.resize(resampler.process(input.data(), static_cast<int>(input.size()), output.data(), 2));
+
+        double alias = std::fmod(frequency, samplingFrequency);
+        alias = std::min(alias, samplingFrequency - alias);
+
+        // Skip the start, until the filters settle
+        const std::size_t start = output.size() / 4;
+        const std::size_t n = output.size() - start;
+        double re = 0.;
+        double im = 0.;
+        double weight = 0.;
+        for (std::size_t k = 0; k < n; k++) {
+            const double w = 0.5 - 0.5 * std::cos(twoPi * k / n);
+            const double phase = twoPi * alias * k / samplingFrequency;
+            re += w * output[start + k] * std::cos(phase);
+            im += w * output[start + k] * std::sin(phase);
+            weight += w;
+        }
+        return 20. * std::log10(2. * std::hypot(re, im) / weight / 32000. + 1e-12);
+    }
+
+    /**
+     * The minimum phase filters keep the stopband attenuation of the linear phase ones,
+     * for a single SINC, two chained ones and after half-band decimators.
+     */
+    void testMinimumPhaseStopband() {
+        double worst[2] = {-200., -200.};
+
+        for (double samplingFrequency: {8000., 48000., 96000.}) {
+            const double stopband = samplingFrequency - sid::TwoPassSincResampler::defaultPassband(samplingFrequency);
+            double power[2] = {0., 0.};
+
+            for (int minimumPhase = 0; minimumPhase < 2; minimumPhase++) {
+                const int steps = 30;
+                for (int s = 0; s < steps; s++) {
+                    const double frequency = stopband + (985248. / 2. - stopband) * (s + 0.5) / steps;
+                    std::unique_ptr<sid::Resampler> resampler(
+                            sid::CascadeResampler::create(985248., samplingFrequency, 0., minimumPhase != 0));
+                    const double level = aliasLevel(*resampler, samplingFrequency, frequency);
+                    power[minimumPhase] += std::pow(10., level / 10.);
+                    worst[minimumPhase] = std::max(worst[minimumPhase], level);
+                }
+            }
+
+            // The coefficients round differently, so single frequencies may go either way
+            CHECK(10. * std::log10(power[1] / power[0]) <= 1.);
+        }
+
+        CHECK(worst[1] <= worst[0]);
+    }
+
+    /**
+     * Cache files are only used when their header and checksum match,
+     * damaged or outdated files are ignored and the tables are built again.
+     */
+    void testCacheFiles() {
+        namespace fs = std::filesystem;
+
+        const fs::path dir = fs::temp_directory_path() / ("residfp-test-" + std::to_string(std::random_device()()));
+        fs::create_directories(dir);
+        sid::FilterTableCache::setDirectory(dir.string().c_str());
+
+        const std::size_t size = 1000;
+        std::vector<unsigned char> tables(size);
+        for (std::size_t i = 0; i < size; i++)
+            tables[i] = static_cast<unsigned char>(i * 7);
+
+        {
+            sid::FilterTableCache cache("test", 1234, size);
+            std::copy(tables.begin(), tables.end(), cache.getData());
+            cache.store();
+        }
+
+        const fs::path file = fs::directory_iterator(dir)->path();
+        std::vector<char> original(fs::file_size(file));
+        std::ifstream(file, std::ios::binary).read(original.data(), original.size());
+
+        bool same = false;
+
+        // Whether the tables are loaded from the given file contents
+        auto loads = [&](const std::vector<char> &contents) {
+            std::ofstream(file, std::ios::binary | std::ios::trunc).write(contents.data(), contents.size());
+            sid::FilterTableCache cache("test", 1234, size);
+            same = std::equal(tables.begin(), tables.end(), cache.getData());
+            return cache.isLoaded();
+        };
+
+        const std::size_t header = original.size() - ((size + 7) & ~7);
+
+        std::vector<char> tableChanged(original);
+        tableChanged[header + 100] ^= 1;
+        std::vector<char> versionChanged(original);
+        versionChanged[8] ^= 1;
+        std::vector<char> truncated(original.begin(), original.end() - 8);
+        std::vector<char> extended(original);
+        extended.insert(extended.end(), 8, 0);
+
+        const bool loaded = loads(original);
+        const bool loadedSame = same;
+        const bool results[] = {
+            loads(tableChanged),
+            loads(versionChanged),
+            loads(truncated),
+            loads(extended),
+        };
+
+        sid::FilterTableCache::setDirectory("");
+        fs::remove_all(dir);
+
+        CHECK(loaded);
+        CHECK(loadedSame);
+        for (bool result: results)
+            CHECK(!result);
+    }
+
+    /**
+     * One SID::clock call gives the same samples as many shorter ones.
+     */
+    void testClockChunks() {
+        std::mt19937 rng(144);
+
+        for (sid::SamplingMethod method: {sid::DECIMATE, sid::RESAMPLE, sid::RESAMPLE_MINIMUM_PHASE}) {
+            for (bool densePhases: {false, true}) {
+                std::vector<short> samples[2];
+
+                for (int chunked = 0; chunked < 2; chunked++) {
+                    sid::SID chip(sid::MOS8580);
+                    chip.setSamplingParameters(985248., method, 44100., 0., densePhases);
+
+                    chip.write(0x18, 0x1f); // Low pass, maximum volume
+                    chip.write(0x17, 0xf1); // Voice 1 filtered, maximum resonance
+                    chip.write(0x16, 0x30);
+                    chip.write(0x01, 0x1c);
+                    chip.write(0x03, 0x08);
+                    chip.write(0x05, 0x22);
+                    chip.write(0x06, 0xa8);
+                    chip.write(0x04, 0x41); // Pulse, gate
+
+                    const unsigned int cycles = 200000;
+                    samples[chunked].resize(cycles);
+                    int n = 0;
+                    for (unsigned int done = 0; done < cycles;) {
+                        const unsigned int len = chunked ? std::min(cycles - done, chunkSize(rng)) : cycles;
+                        n += chip.clock(len, samples[chunked].data() + n);
+                        done += len;
+                    }
+                    samples[chunked].resize(n);
+                }
+
+                CHECK(!samples[0].empty());
+                CHECK(samples[0] == samples[1]);
+            }
+        }
+    }
+
+}
+
+int main() {
+    testConcurrentChips();
+    testFilterSettingChanges();
+    testConvolutions();
+    testWaveformBlocks();
+    testFusedWaveforms();
+    testSteadyState();
+    testResamplerBlocks();
+    testMinimumPhaseStopband();
+    testClockChunks();
+    testCacheFiles();
+
+    if (failures != 0) {
+        std::fprintf(stderr, "%d test(s) failed\n", failures);
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}